@@ -0,0 +1,1333 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "membership.h"
+#include "membership_config.h"
+#include "node.h"
+#include "dissemination.h"
+#include "join.h"
+#include "log.h"
+#include "member_id.h"
+#include "persist.h"
+#include "piggyback.h"
+#include "ring.h"
+#include "sender.h"
+#include "shm_view.h"
+#include "table_print.h"
+#include "time_util.h"
+#include "vivaldi.h"
+#include "zones.h"
+
+static size_t arg_or(const std::vector<std::string>& args, size_t i, size_t def) {
+    if (i >= args.size()) return def;
+    try { return (size_t)std::stoull(args[i]); } catch (...) { return def; }
+}
+
+static size_t rss_kb() {
+    std::ifstream in("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(in >> pages >> resident)) return 0;
+    return resident * (size_t)sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point since) {
+    using namespace std::chrono;
+    return (double)duration_cast<nanoseconds>(steady_clock::now() - since).count() / 1000.0;
+}
+
+// Members join and leave in a loop on virtual time; the view, the tombstones
+// and the cost of building a piggyback should stay flat once the retention
+// windows fill up.
+static int bench_churn(const std::vector<std::string>& args) {
+    const size_t cycles = arg_or(args, 0, 100000);
+    const uint64_t step_ms = arg_or(args, 1, 10);
+    const size_t report_every = std::max<size_t>(cycles / 10, 1);
+
+    Node node({});
+    uint64_t t = 1000000;
+
+    std::vector<std::vector<std::string>> rows;
+
+    for (size_t i = 1; i <= cycles; i++) {
+        const std::string name = "churn-" + std::to_string(i);
+        const std::string ip = "10." + std::to_string((i >> 16) & 255) + "."
+                             + std::to_string((i >> 8) & 255) + "." + std::to_string(i & 255);
+        {
+            std::lock_guard<std::mutex> lk(node.membership_mu);
+            merge_member(node, name, ip, "1", MemberStatus::Alive, t, true);
+            merge_member(node, name, ip, "1", MemberStatus::Dead, t, false);
+
+            // Stale gossip about a member reclaimed long ago.
+            if (i > 5000) {
+                const std::string old = "churn-" + std::to_string(i - 5000);
+                merge_member(node, old, ip, "1", MemberStatus::Alive, t, false);
+            }
+
+            if (i % 100 == 0) reclaim_dead_members(node, t);
+        }
+        t += step_ms;
+
+        if (i % report_every == 0) {
+            auto start = std::chrono::steady_clock::now();
+            const size_t reps = 1000;
+            size_t bytes = 0;
+            for (size_t r = 0; r < reps; r++) bytes += build_piggy_data(node, "", PIGGY_K).size();
+            const double piggy_us = elapsed_us(start) / (double)reps;
+            (void)bytes;
+
+            size_t members, tombs, tomb_bytes;
+            {
+                std::lock_guard<std::mutex> lk(node.membership_mu);
+                members = node.membership.size();
+                tombs = node.tombstones.size();
+                tomb_bytes = node.tombstones.memory_bytes();
+            }
+
+            char piggy[32];
+            snprintf(piggy, sizeof(piggy), "%.2f", piggy_us);
+
+            rows.push_back({
+                std::to_string(i),
+                std::to_string(members),
+                std::to_string(tombs),
+                std::to_string(tomb_bytes / 1024),
+                std::to_string(rss_kb()),
+                piggy
+            });
+        }
+    }
+
+    std::cout << "churn: " << cycles << " join/leave cycles, " << step_ms
+              << " ms apart (DEAD_RETAIN_MS=" << DEAD_RETAIN_MS
+              << ", TOMBSTONE_MS=" << TOMBSTONE_MS
+              << ", MAX_TOMBSTONES=" << MAX_TOMBSTONES << ")\n";
+    print_table({ "CYCLES", "MEMBERS", "TOMBSTONES", "TOMB_KB", "RSS_KB", "PIGGY_US" }, rows);
+    return 0;
+}
+
+// Join storm on virtual time: N joiners start within `spread_ms` against S
+// seeds that already know E members. Seeds are real Nodes; each JOIN costs
+// the measured CPU time of the receive path (merge, gate, reply payload)
+// plus a fixed per-datagram syscall cost, and a seed drops JOINs once its
+// backlog exceeds the socket buffer. Redirect targets answer after one RTT.
+// The baseline is the old behaviour: fixed 750 ms retries to every seed and
+// a fresh WELCOME per JOIN.
+
+static constexpr uint64_t STORM_LATENCY_US  = 500;     // one way
+static constexpr uint64_t STORM_SYSCALL_US  = 10;      // recv + send
+static constexpr uint64_t STORM_BACKLOG_US  = 50000;   // socket buffer
+static constexpr uint64_t STORM_LIMIT_US    = 300000000;
+
+struct StormResult {
+    uint64_t seed_joins = 0;
+    uint64_t dropped = 0;
+    uint64_t payloads = 0;
+    uint64_t redirects = 0;
+    double seed_cpu_us = 0;
+    size_t joined = 0;
+    uint64_t all_joined_us = 0;
+    uint64_t p50_us = 0;
+    uint64_t p99_us = 0;
+};
+
+static std::string storm_ip(unsigned net, size_t i) {
+    return "10." + std::to_string(net) + "." + std::to_string((i >> 8) & 255) + "." + std::to_string(i & 255);
+}
+
+static StormResult run_join_storm(bool controlled, size_t joiners, size_t n_seeds,
+                                  uint64_t spread_ms, size_t existing) {
+    enum Kind { Start, Timer, SeedRecv, HelperRecv, Welcome, Redirect };
+    struct Ev {
+        uint64_t t_us;
+        Kind kind;
+        size_t who;
+        size_t seed;
+        bool operator>(const Ev& o) const { return t_us > o.t_us; }
+    };
+    struct Joiner {
+        std::string name, ip;
+        uint64_t start_us = 0;
+        uint64_t joined_us = 0;
+        bool joined = false;
+        unsigned attempt = 0;
+        size_t hints = 0;
+    };
+
+    std::vector<std::string> seed_ips;
+    for (size_t s = 0; s < n_seeds; s++) seed_ips.push_back(storm_ip(200, s + 1));
+
+    std::vector<std::unique_ptr<Node>> seeds;
+    std::vector<uint64_t> busy_until(n_seeds, 0);
+    for (size_t s = 0; s < n_seeds; s++) {
+        auto node = std::make_unique<Node>(seed_ips);
+        node->name = "seed-" + std::to_string(s);
+        node->ip = seed_ips[s];
+        node->is_seed = true;
+
+        std::lock_guard<std::mutex> lk(node->membership_mu);
+        for (size_t i = 0; i < existing; i++)
+            merge_member(*node, "member-" + std::to_string(i), storm_ip(1, i), "1",
+                         MemberStatus::Alive, 0, true);
+        seeds.push_back(std::move(node));
+    }
+
+    std::mt19937 rng(42);
+    std::vector<Joiner> js(joiners);
+    std::priority_queue<Ev, std::vector<Ev>, std::greater<Ev>> q;
+
+    for (size_t i = 0; i < joiners; i++) {
+        js[i].name = "joiner-" + std::to_string(i);
+        js[i].ip = storm_ip(2, i);
+        js[i].start_us = std::uniform_int_distribution<uint64_t>(0, spread_ms * 1000)(rng);
+        q.push({ js[i].start_us, Start, i, 0 });
+    }
+
+    StormResult r;
+
+    auto send_to_seeds = [&](uint64_t t, size_t who) {
+        for (size_t s = 0; s < n_seeds; s++) q.push({ t + STORM_LATENCY_US, SeedRecv, who, s });
+    };
+
+    while (!q.empty()) {
+        const Ev ev = q.top();
+        q.pop();
+        if (ev.t_us > STORM_LIMIT_US) break;
+
+        Joiner& j = js[ev.who];
+
+        switch (ev.kind) {
+        case Start:
+        case Timer: {
+            if (j.joined) break;
+            if (controlled && j.hints > 0) {
+                for (size_t h = 0; h < j.hints; h++) q.push({ ev.t_us + STORM_LATENCY_US, HelperRecv, ev.who, 0 });
+                j.hints = 0;
+            } else {
+                send_to_seeds(ev.t_us, ev.who);
+            }
+            const uint64_t delay_ms = controlled ? join_backoff_ms(j.attempt, rng) : 750;
+            j.attempt++;
+            q.push({ ev.t_us + delay_ms * 1000, Timer, ev.who, 0 });
+            break;
+        }
+
+        case SeedRecv: {
+            r.seed_joins++;
+            uint64_t& busy = busy_until[ev.seed];
+            if (busy > ev.t_us + STORM_BACKLOG_US) { r.dropped++; break; }
+
+            Node& seed = *seeds[ev.seed];
+            const uint64_t now = std::max(busy, ev.t_us);
+            const uint64_t now_ms = now / 1000;
+
+            auto t0 = std::chrono::steady_clock::now();
+            Kind reply = Welcome;
+            bool sent = true;
+            size_t bytes = 0;
+            {
+                std::lock_guard<std::mutex> lk(seed.membership_mu);
+                merge_member(seed, j.name, j.ip, "1", MemberStatus::Alive, now_ms, true);
+            }
+            if (controlled) {
+                const JoinAction a = seed.join_gate.admit(j.name, 1, now_ms, true);
+                if (a == JoinAction::Drop) {
+                    sent = false;
+                } else {
+                    std::string targets;
+                    if (a == JoinAction::Redirect) targets = seed.join_gate.redirect_targets(seed, j.name, now_ms);
+                    if (!targets.empty()) {
+                        reply = Redirect;
+                        bytes = make_msg("REDIRECT", seed, targets).size();
+                    } else {
+                        bytes = make_msg("WELCOME", seed, seed.join_gate.welcome_payload(seed, now_ms)).size();
+                    }
+                }
+            } else {
+                bytes = make_msg("WELCOME", seed, build_piggy_data(seed, j.name, PIGGY_K)).size();
+                r.payloads++;
+            }
+            (void)bytes;
+            const double cost = elapsed_us(t0) + (double)STORM_SYSCALL_US;
+
+            r.seed_cpu_us += cost;
+            busy = now + (uint64_t)cost;
+            if (sent) q.push({ busy + STORM_LATENCY_US, reply, ev.who, ev.seed });
+            break;
+        }
+
+        case HelperRecv:
+            q.push({ ev.t_us + STORM_LATENCY_US, Welcome, ev.who, 0 });
+            break;
+
+        case Welcome:
+            if (!j.joined) {
+                j.joined = true;
+                j.joined_us = ev.t_us - j.start_us;
+                r.joined++;
+                r.all_joined_us = std::max(r.all_joined_us, ev.t_us);
+            }
+            break;
+
+        case Redirect:
+            if (j.joined) break;
+            r.redirects++;
+            j.hints = JOIN_REDIRECT_K;
+            for (size_t h = 0; h < j.hints; h++) q.push({ ev.t_us + STORM_LATENCY_US, HelperRecv, ev.who, 0 });
+            break;
+        }
+
+        if (r.joined == joiners) break;
+    }
+
+    if (controlled)
+        for (const auto& s : seeds) r.payloads += s->join_gate.stats().welcomes_built;
+
+    std::vector<uint64_t> lat;
+    for (const auto& j : js) if (j.joined) lat.push_back(j.joined_us);
+    std::sort(lat.begin(), lat.end());
+    if (!lat.empty()) {
+        r.p50_us = lat[lat.size() / 2];
+        r.p99_us = lat[std::min(lat.size() - 1, lat.size() * 99 / 100)];
+    }
+    return r;
+}
+
+static int bench_joinstorm(const std::vector<std::string>& args) {
+    const size_t joiners = arg_or(args, 0, 5000);
+    const size_t n_seeds = std::max<size_t>(arg_or(args, 1, 2), 1);
+    const uint64_t spread_ms = arg_or(args, 2, 200);
+    const size_t existing = arg_or(args, 3, 100);
+
+    auto ms = [](double us) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.1f", us / 1000.0);
+        return std::string(buf);
+    };
+
+    std::vector<std::vector<std::string>> rows;
+    for (bool controlled : { false, true }) {
+        const StormResult r = run_join_storm(controlled, joiners, n_seeds, spread_ms, existing);
+        rows.push_back({
+            controlled ? "controlled" : "baseline",
+            std::to_string(r.seed_joins),
+            std::to_string(r.dropped),
+            std::to_string(r.payloads),
+            std::to_string(r.redirects),
+            ms(r.seed_cpu_us),
+            std::to_string(r.joined) + "/" + std::to_string(joiners),
+            r.joined == joiners ? ms((double)r.all_joined_us) : "-",
+            ms((double)r.p50_us),
+            ms((double)r.p99_us)
+        });
+    }
+
+    std::cout << "joinstorm: " << joiners << " joiners over " << spread_ms << " ms, "
+              << n_seeds << " seeds, " << existing << " existing members (virtual time)\n";
+    print_table({ "POLICY", "SEED_JOINS", "DROPPED", "PAYLOADS", "REDIRECTS",
+                  "SEED_CPU_MS", "JOINED", "ALL_JOINED_MS", "P50_MS", "P99_MS" }, rows);
+    return 0;
+}
+
+// Floods a real UdpQueue with JOIN and PING-TEST datagrams at `rate`/s
+// while a prober enqueues one PING and one ACK per millisecond, as a
+// monitored peer would. Replies go to loopback. A probe reply that is
+// dropped or waits longer than PING_TIMEOUT_MS would become a false
+// suspicion.
+static int bench_overload(const std::vector<std::string>& args) {
+    const uint64_t seconds = std::max<size_t>(arg_or(args, 0, 3), 1);
+    const uint64_t rate = arg_or(args, 1, 200000);
+
+    sockaddr_in from{};
+    from.sin_family = AF_INET;
+    from.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<std::vector<std::string>> rows;
+    std::vector<std::string> verdicts;
+
+    for (OverloadPolicy policy : { OverloadPolicy::DropLowest, OverloadPolicy::DropOldest }) {
+        const char* pname = policy == OverloadPolicy::DropOldest ? "drop-oldest" : "drop-lowest";
+
+        Node node({});
+        node.udpq.set_policy(policy);
+        node.udpq.start(node);
+
+        const std::string ping = "PING prober 127.0.0.1 1";
+        const std::string ack  = "ACK prober 127.0.0.1 1";
+
+        uint64_t offered = 0, n = 0;
+        const uint64_t per_ms = std::max<uint64_t>(rate / 1000, 1);
+        const uint64_t t_end = now_ms() + seconds * 1000;
+
+        for (uint64_t tick = now_ms(); tick < t_end; tick++) {
+            node.udpq.enqueue(from, ping.data(), ping.size());
+            node.udpq.enqueue(from, ack.data(), ack.size());
+
+            for (uint64_t i = 0; i < per_ms; i++, n++) {
+                const std::string m = (n & 1)
+                    ? "PING-TEST flood-" + std::to_string(n % 1000) + " 127.0.0.1 1"
+                    : "JOIN flood-" + std::to_string(n % 1000) + " 127.0.0.1 " + std::to_string(n);
+                node.udpq.enqueue(from, m.data(), m.size());
+            }
+            offered += per_ms;
+
+            const uint64_t now = now_ms();
+            if (now < tick + 1) std::this_thread::sleep_for(std::chrono::milliseconds(tick + 1 - now));
+        }
+
+        uint64_t processed = 0;
+        for (size_t i = 0; i < UDP_LANES; i++) {
+            const UdpLaneStats st = node.udpq.lane_stats((UdpLane)i);
+            processed += st.arrived - st.dropped - st.depth;
+            rows.push_back({
+                pname,
+                udp_lane_name((UdpLane)i),
+                std::to_string(st.arrived),
+                std::to_string(st.dropped),
+                std::to_string(st.max_depth),
+                std::to_string(st.wait_p50_us),
+                std::to_string(st.wait_p99_us),
+                std::to_string(st.wait_max_us)
+            });
+        }
+
+        const UdpLaneStats replies = node.udpq.lane_stats(UdpLane::ProbeReply);
+        const bool late = replies.wait_max_us > PING_TIMEOUT_MS * 1000;
+        verdicts.push_back(std::string(pname) + ": " + std::to_string(replies.dropped)
+                           + " probe replies dropped, " + (late ? "some" : "none")
+                           + " later than PING_TIMEOUT_MS; an unbounded FIFO would hold ~"
+                           + std::to_string(offered > processed ? offered - processed : 0)
+                           + " datagrams ahead of the next ACK");
+
+        node.udpq.stop();
+    }
+
+    std::cout << "overload: " << rate << " flood datagrams/s for " << seconds
+              << " s, capacity " << UDPQ_CAPACITY << "\n";
+    print_table({ "POLICY", "LANE", "ARRIVED", "DROPPED", "MAX_DEPTH", "WAIT_P50_US", "WAIT_P99_US", "WAIT_MAX_US" }, rows);
+    for (const auto& v : verdicts) std::cout << v << "\n";
+    return 0;
+}
+
+// Spread of one failure over N nodes in protocol periods. The detector marks
+// member 0 Dead; every period each other node pings a random live member and
+// both the PING and the ACK carry PIGGY_K entries. The baseline picks them
+// at random (member 0 rides along with probability about k/N); the
+// dissemination policy uses a real Dissemination queue per node and pushes
+// the CONFIRM to FANOUT members straight away.
+static size_t spread_periods(size_t n, bool queued, std::mt19937& rng, size_t cap) {
+    std::vector<char> knows(n, 0);
+    std::vector<Dissemination> queues(queued ? n : 0);
+    const size_t limit = retransmit_limit(n);
+    std::uniform_int_distribution<size_t> pick(1, n - 1);
+
+    size_t informed = 0;
+    auto learn = [&](size_t i) {
+        if (knows[i]) return;
+        knows[i] = 1;
+        informed++;
+        if (queued) queues[i].enqueue("m0");
+    };
+
+    learn(1);
+    if (queued)
+        for (size_t f = 0; f < FANOUT; f++) learn(pick(rng));
+
+    // True if a piggyback from `from` carries member 0's entry.
+    auto carries = [&](size_t from) {
+        if (!knows[from]) return false;
+        size_t k = PIGGY_K;
+        if (queued) {
+            std::vector<std::string> taken = queues[from].take(k, limit);
+            if (!taken.empty()) return true;
+        }
+        for (size_t e = 0; e < k; e++)
+            if (std::uniform_int_distribution<size_t>(0, n - 1)(rng) == 0) return true;
+        return false;
+    };
+
+    for (size_t period = 1; period <= cap; period++) {
+        std::vector<size_t> learned;
+        for (size_t i = 1; i < n; i++) {
+            size_t j = pick(rng);
+            if (j == i) continue;
+            if (carries(i)) learned.push_back(j);
+            if (carries(j)) learned.push_back(i);
+        }
+        for (size_t x : learned) learn(x);
+        if (informed == n - 1) return period;
+    }
+    return cap;
+}
+
+static int bench_dissemination(const std::vector<std::string>& args) {
+    const size_t max_n = std::max<size_t>(arg_or(args, 0, 4096), 16);
+    const size_t trials = std::max<size_t>(arg_or(args, 1, 10), 1);
+    const size_t cap = 100000;
+
+    std::mt19937 rng(7);
+    std::vector<std::vector<std::string>> rows;
+
+    for (size_t n = 16; n <= max_n; n *= 4) {
+        std::vector<size_t> base, queued;
+        for (size_t t = 0; t < trials; t++) {
+            base.push_back(spread_periods(n, false, rng, cap));
+            queued.push_back(spread_periods(n, true, rng, cap));
+        }
+        std::sort(base.begin(), base.end());
+        std::sort(queued.begin(), queued.end());
+
+        size_t log2n = 0;
+        while (((size_t)1 << log2n) < n) log2n++;
+
+        rows.push_back({
+            std::to_string(n),
+            std::to_string(log2n),
+            std::to_string(base[trials / 2]),
+            std::to_string(base.back()),
+            std::to_string(queued[trials / 2]),
+            std::to_string(queued.back()),
+            std::to_string(retransmit_limit(n))
+        });
+    }
+
+    std::cout << "dissemination: periods until every member knows of one failure (PIGGY_K="
+              << PIGGY_K << ", FANOUT=" << FANOUT << ", " << trials << " trials)\n";
+    print_table({ "N", "LOG2_N", "RANDOM_P50", "RANDOM_MAX", "QUEUED_P50", "QUEUED_MAX", "RETRANSMITS" }, rows);
+    return 0;
+}
+
+// Consistent-hash ring: cost of building it member by member, lookup
+// throughput for owner() and 3-replica lookups, the cost of one member
+// leaving and rejoining, and how many keys move when that happens (ideally
+// about 1/N).
+static int bench_ring(const std::vector<std::string>& args) {
+    const size_t max_n = std::max<size_t>(arg_or(args, 0, 10000), 10);
+    const size_t lookups = std::max<size_t>(arg_or(args, 1, 1000000), 1000);
+    const size_t probe_keys = 20000;
+
+    std::vector<std::vector<std::string>> rows;
+    auto fmt = [](double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.2f", v);
+        return std::string(buf);
+    };
+
+    for (size_t n = 10; n <= max_n; n *= 10) {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < n; i++) names.push_back("member-" + std::to_string(i));
+
+        HashRing ring;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& name : names) ring.add(name);
+        const double build_us = elapsed_us(t0);
+        const size_t points = ring.points();
+
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < 4096; i++) keys.push_back("key-" + std::to_string(i * 7919));
+
+        size_t sink = 0;
+        t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; i++) sink += ring.owner(keys[i & 4095]).size();
+        const double owner_ns = elapsed_us(t0) * 1000.0 / (double)lookups;
+
+        t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups / 10; i++) sink += ring.replicas(keys[i & 4095], 3).size();
+        const double replica_ns = elapsed_us(t0) * 1000.0 / (double)(lookups / 10);
+
+        std::vector<std::string> before;
+        for (size_t i = 0; i < probe_keys; i++) before.push_back(ring.owner("probe-" + std::to_string(i)));
+
+        const size_t churns = std::min<size_t>(n, 200);
+        t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < churns; i++) {
+            ring.remove(names[i]);
+            ring.add(names[i]);
+        }
+        const double churn_us = elapsed_us(t0) / (double)(churns * 2);
+
+        ring.remove(names[n / 2]);
+        size_t moved = 0;
+        for (size_t i = 0; i < probe_keys; i++)
+            if (ring.owner("probe-" + std::to_string(i)) != before[i]) moved++;
+        (void)sink;
+
+        rows.push_back({
+            std::to_string(n),
+            std::to_string(points),
+            fmt(build_us / 1000.0),
+            fmt(owner_ns),
+            fmt(replica_ns),
+            fmt(churn_us),
+            fmt(100.0 * (double)moved / (double)probe_keys),
+            fmt(100.0 / (double)n)
+        });
+    }
+
+    std::cout << "ring: " << RING_VNODES << " points per member, " << lookups << " lookups per size\n";
+    print_table({ "MEMBERS", "POINTS", "BUILD_MS", "OWNER_NS", "REPLICAS3_NS", "CHURN_US", "MOVED_%", "IDEAL_%" }, rows);
+    return 0;
+}
+
+// Vivaldi on a synthetic datacenter: members spread over racks whose
+// centres sit on a plane (inter-rack RTT 1-40 ms), plus a per-member access
+// delay and 5% jitter per sample. Each period every member probes one random
+// peer and updates its coordinate. Reports the relative error of the
+// estimates and the true helper->target RTT when PING-REQ helpers are
+// picked at random versus by coordinate.
+static int bench_vivaldi(const std::vector<std::string>& args) {
+    const size_t n = std::max<size_t>(arg_or(args, 0, 256), FANOUT + 2);
+    const size_t racks = std::max<size_t>(arg_or(args, 1, 8), 1);
+    const size_t periods = std::max<size_t>(arg_or(args, 2, 100), 1);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> plane(0.0, 20.0);
+    std::uniform_real_distribution<double> access(0.05, 0.3);
+    std::uniform_real_distribution<double> jitter(0.95, 1.05);
+
+    std::vector<std::pair<double, double>> centre(racks);
+    for (auto& c : centre) c = { plane(rng), plane(rng) };
+
+    std::vector<size_t> rack(n);
+    std::vector<double> acc(n);
+    for (size_t i = 0; i < n; i++) { rack[i] = i % racks; acc[i] = access(rng); }
+
+    auto rtt = [&](size_t a, size_t b) {
+        const auto& ca = centre[rack[a]];
+        const auto& cb = centre[rack[b]];
+        const double dx = ca.first - cb.first, dy = ca.second - cb.second;
+        const double wire = rack[a] == rack[b] ? 0.1 : 1.0 + std::sqrt(dx * dx + dy * dy);
+        return wire + acc[a] + acc[b];
+    };
+
+    std::vector<Coord> coords(n);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    auto fmt = [](double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.3f", v);
+        return std::string(buf);
+    };
+
+    std::vector<std::vector<std::string>> rows;
+    double update_ns = 0;
+    size_t updates = 0;
+
+    for (size_t period = 1; period <= periods; period++) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            size_t j = pick(rng);
+            if (j == i) j = (j + 1) % n;
+            const Coord remote = coords[j];
+            vivaldi_update(coords[i], remote, rtt(i, j) * jitter(rng), rng);
+        }
+        update_ns += elapsed_us(t0) * 1000.0;
+        updates += n;
+
+        if (period != periods && period != 1 && period % (periods / 5 ? periods / 5 : 1) != 0) continue;
+
+        std::vector<double> rel;
+        for (size_t s = 0; s < 4000; s++) {
+            const size_t a = pick(rng), b = pick(rng);
+            if (a == b) continue;
+            const double real = rtt(a, b);
+            rel.push_back(std::fabs(coord_distance(coords[a], coords[b]) - real) / real);
+        }
+        std::sort(rel.begin(), rel.end());
+
+        // Helper choice for random (prober, target) pairs.
+        double random_ms = 0, nearest_ms = 0, random_same = 0, nearest_same = 0;
+        const size_t trials = 2000;
+        std::vector<size_t> helpers;
+        for (size_t t = 0; t < trials; t++) {
+            const size_t prober = pick(rng), target = pick(rng);
+            helpers.clear();
+            for (size_t h = 0; h < n; h++)
+                if (h != prober && h != target) helpers.push_back(h);
+            std::shuffle(helpers.begin(), helpers.end(), rng);
+
+            for (size_t k = 0; k < FANOUT; k++) {
+                random_ms += rtt(helpers[k], target);
+                random_same += rack[helpers[k]] == rack[target];
+            }
+
+            std::partial_sort(helpers.begin(), helpers.begin() + FANOUT, helpers.end(), [&](size_t x, size_t y) {
+                return coord_distance(coords[x], coords[target]) < coord_distance(coords[y], coords[target]);
+            });
+            for (size_t k = 0; k < FANOUT; k++) {
+                nearest_ms += rtt(helpers[k], target);
+                nearest_same += rack[helpers[k]] == rack[target];
+            }
+        }
+        const double picks = (double)(trials * FANOUT);
+
+        rows.push_back({
+            std::to_string(period),
+            fmt(rel[rel.size() / 2]),
+            fmt(rel[rel.size() * 9 / 10]),
+            fmt(random_ms / picks),
+            fmt(nearest_ms / picks),
+            fmt(100.0 * random_same / picks),
+            fmt(100.0 * nearest_same / picks)
+        });
+    }
+
+    std::cout << "vivaldi: " << n << " members in " << racks << " racks, " << VIVALDI_DIM
+              << "-d + height, one probe per member per period, "
+              << fmt(update_ns / (double)updates) << " ns per update\n";
+    print_table({ "PERIOD", "REL_ERR_P50", "REL_ERR_P90", "HELPER_RTT_RANDOM", "HELPER_RTT_NEAREST",
+                  "SAME_RACK_RANDOM_%", "SAME_RACK_NEAREST_%" }, rows);
+    return 0;
+}
+
+// Wire size of a PING with full names versus compact member IDs, for short
+// cluster hostnames and cloud-style FQDNs. ENTRIES_FIT is how many gossip
+// entries one datagram of `budget` bytes could carry next to the header and
+// the trailer fields.
+static int bench_wire(const std::vector<std::string>& args) {
+    const size_t n = std::max<size_t>(arg_or(args, 0, 1000), PIGGY_K + 1);
+    const size_t budget = std::max<size_t>(arg_or(args, 1, 1400), 128);
+    const size_t reps = 2000;
+
+    std::vector<std::vector<std::string>> rows;
+    auto fmt = [](double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.1f", v);
+        return std::string(buf);
+    };
+
+    for (bool fqdn : { false, true }) {
+        Node node({});
+        std::string target;
+        {
+            std::lock_guard<std::mutex> lk(node.membership_mu);
+            for (size_t i = 0; i < n; i++) {
+                const std::string a = std::to_string((i >> 8) & 255), b = std::to_string(i & 255);
+                const std::string ip = "10.20." + a + "." + b;
+                const std::string name = fqdn ? "ip-10-20-" + a + "-" + b + ".eu-west-1.compute.internal"
+                                              : "node" + std::to_string(i);
+                merge_member(node, name, ip, "7", MemberStatus::Alive, now_ms(), true);
+                if (target.empty()) target = name;
+            }
+        }
+
+        double full_bytes = 0;
+        for (bool compact : { false, true }) {
+            {
+                std::lock_guard<std::mutex> lk(node.membership_mu);
+                MemberInfo& t = node.membership[target];
+                t.id_ack = compact;
+                t.id_ack_inc = t.incarnation;
+            }
+
+            size_t msg_bytes = 0, entry_bytes = 0, trailer_bytes = 0, entries = 0;
+            std::string csv;
+            PiggyFields fields;
+            for (size_t r = 0; r < reps; r++) {
+                const std::string piggy = build_piggy_data(node, target, PIGGY_K);
+                msg_bytes += make_msg("PING", node, piggy, compact).size();
+
+                split_piggy_data(piggy, csv, fields);
+                entries += csv.empty() ? 0 : (size_t)std::count(csv.begin(), csv.end(), ',') + 1;
+                entry_bytes += csv.size();
+                trailer_bytes += piggy.size() - csv.size();
+            }
+
+            const double header = (double)make_msg("PING", node, "", compact).size();
+            const double per_entry = (double)entry_bytes / (double)entries + 1.0;   // with its comma
+            const double trailer = (double)trailer_bytes / (double)reps;
+            const double msg = (double)msg_bytes / (double)reps;
+            if (!compact) full_bytes = msg;
+
+            rows.push_back({
+                fqdn ? "fqdn" : "short",
+                compact ? "compact" : "full",
+                fmt(header),
+                fmt(per_entry),
+                fmt(msg),
+                compact ? fmt(100.0 * (1.0 - msg / full_bytes)) + "%" : "-",
+                std::to_string((size_t)(((double)budget - header - trailer) / per_entry))
+            });
+        }
+    }
+
+    std::cout << "wire: PING with PIGGY_K=" << PIGGY_K << " entries, " << n
+              << " members, ENTRIES_FIT for a " << budget << "-byte datagram\n";
+    print_table({ "NAMES", "FORM", "HEADER_B", "ENTRY_B", "PING_B", "SAVED", "ENTRIES_FIT" }, rows);
+    return 0;
+}
+
+// A worker that logs once per item while the log sink (a pipe) is read only
+// in bursts, like a terminal or disk that stalls. "sync" writes each line
+// straight to the pipe as std::cout/perror did; "async" goes through the
+// background logger, with and without the per-site rate limit.
+static int bench_logging(const std::vector<std::string>& args) {
+    const size_t items = std::max<size_t>(arg_or(args, 0, 20000), 100);
+    const uint64_t stall_ms = arg_or(args, 1, 50);
+
+    std::vector<std::vector<std::string>> rows;
+    auto fmt = [](double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.1f", v);
+        return std::string(buf);
+    };
+
+    for (int mode = 0; mode < 3; mode++) {
+        int fds[2];
+        if (pipe(fds) < 0) { perror("pipe"); return 1; }
+
+        std::atomic<bool> done{false};
+        std::thread reader([&] {
+            char buf[65536];
+            while (!done.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms));
+                if (read(fds[0], buf, sizeof(buf)) <= 0) break;
+            }
+        });
+
+        log_set_fd(fds[1]);
+        log_set_site_rate(mode == 2 ? LOG_SITE_RATE : 0);
+        if (mode > 0) log_start();
+        const LogStats before = log_stats();
+
+        std::vector<double> lat;
+        lat.reserve(items);
+        uint64_t work = 0;
+        const uint64_t t0 = now_us();
+
+        for (size_t i = 0; i < items; i++) {
+            const auto s = std::chrono::steady_clock::now();
+            for (int k = 0; k < 200; k++) work = work * 6364136223846793005ULL + i;
+
+            if (mode == 0) {
+                char line[128];
+                const int n = snprintf(line, sizeof(line), "udp sendto 10.0.0.%zu: No buffer space available (%llu)\n",
+                                       i & 255, (unsigned long long)(work & 0xffff));
+                if (write(fds[1], line, (size_t)n) < 0) break;
+            } else {
+                log_warn("udp sendto 10.0.0.%zu: No buffer space available (%llu)",
+                         i & 255, (unsigned long long)(work & 0xffff));
+            }
+            lat.push_back(elapsed_us(s));
+        }
+        const uint64_t total_us = now_us() - t0;
+
+        // Unblock the sink so the drain in log_stop() can finish.
+        done.store(true);
+        const int flags = fcntl(fds[1], F_GETFL);
+        fcntl(fds[1], F_SETFL, flags | O_NONBLOCK);
+        if (mode > 0) log_stop();
+        const LogStats after = log_stats();
+        log_set_fd(STDOUT_FILENO);
+        close(fds[1]);
+        reader.join();
+        close(fds[0]);
+
+        std::sort(lat.begin(), lat.end());
+        rows.push_back({
+            mode == 0 ? "sync" : mode == 1 ? "async" : "async+rate",
+            fmt(lat[lat.size() / 2]),
+            fmt(lat[lat.size() * 99 / 100]),
+            fmt(lat.back()),
+            fmt(total_us / 1000.0),
+            mode == 0 ? "-" : std::to_string(after.dropped - before.dropped),
+            mode == 0 ? "-" : std::to_string(after.suppressed - before.suppressed)
+        });
+    }
+    log_set_site_rate(LOG_SITE_RATE);
+
+    std::cout << "logging: " << items << " items, one log line each; sink read every "
+              << stall_ms << " ms (ring " << LOG_RING_SLOTS << " slots)\n";
+    print_table({ "MODE", "ITEM_P50_US", "ITEM_P99_US", "ITEM_MAX_US", "TOTAL_MS", "DROPPED", "SUPPRESSED" }, rows);
+    return 0;
+}
+
+// Lookups by name from `readers` threads while a churn thread changes a
+// member every millisecond: through the shared-memory table (ShmView, as a
+// co-located process would) versus std::map under membership_mu.
+static int bench_shm(const std::vector<std::string>& args) {
+    const size_t n = std::max<size_t>(arg_or(args, 0, 5000), 10);
+    const size_t readers = std::max<size_t>(arg_or(args, 1, 4), 1);
+    const uint64_t run_ms = 1000;
+    const char* const shm_name = "/gds-bench-shm";
+
+    Node node({});
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        for (size_t i = 0; i < n; i++) {
+            names.push_back("member-" + std::to_string(i));
+            const std::string ip = "10.30." + std::to_string((i >> 8) & 255) + "." + std::to_string(i & 255);
+            merge_member(node, names.back(), ip, "1", MemberStatus::Alive, now_ms(), true);
+        }
+    }
+    node.shm.start(node, shm_name);
+    if (!node.shm.active()) return 1;
+
+    std::vector<std::vector<std::string>> rows;
+    auto fmt = [](double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.1f", v);
+        return std::string(buf);
+    };
+
+    for (bool shared : { true, false }) {
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> reads{0}, misses{0};
+
+        std::thread churn([&] {
+            for (size_t i = 0; !stop.load(); i++) {
+                {
+                    std::lock_guard<std::mutex> lk(node.membership_mu);
+                    MemberInfo& m = node.membership[names[i % n]];
+                    const MemberState before = state_of(m);
+                    m.incarnation++;
+                    node.on_member_change(names[i % n], before, &m);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        const uint64_t publishes0 = node.shm.publishes();
+        std::vector<std::thread> threads;
+        for (size_t r = 0; r < readers; r++) {
+            threads.emplace_back([&, r] {
+                std::mt19937_64 rng(r);
+                ShmView view;
+                if (shared && !view.open(shm_name)) return;
+
+                uint64_t local = 0, miss = 0, sink = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const std::string& name = names[rng() % n];
+                    if (shared) {
+                        ShmMember m;
+                        if (view.find(name, m)) sink += m.incarnation; else miss++;
+                    } else {
+                        std::lock_guard<std::mutex> lk(node.membership_mu);
+                        auto it = node.membership.find(name);
+                        if (it != node.membership.end()) sink += it->second.incarnation; else miss++;
+                    }
+                    local++;
+                }
+                (void)sink;
+                reads += local;
+                misses += miss;
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(run_ms));
+        stop.store(true);
+        for (auto& t : threads) t.join();
+        churn.join();
+
+        const double per_s = (double)reads.load() * 1000.0 / (double)run_ms;
+        rows.push_back({
+            shared ? "shm" : "mutex",
+            fmt(per_s / 1e6),
+            fmt(1e9 * (double)readers / per_s),
+            std::to_string(misses.load()),
+            shared ? std::to_string(node.shm.publishes() - publishes0) : "-"
+        });
+    }
+
+    node.shm.stop();
+    shm_unlink(shm_name);
+
+    std::cout << "shm: " << n << " members, " << readers << " reader threads, one change per ms, "
+              << run_ms << " ms per mode\n";
+    print_table({ "MODE", "MREADS_PER_S", "NS_PER_READ", "MISSES", "PUBLISHES" }, rows);
+    return 0;
+}
+
+// Zoned cluster on virtual time. Every member is a real Node: its heartbeat
+// ticks every TICK_MS and every datagram it sends goes through
+// UdpQueue::handle_datagram at the receiver, ZSIM_LOCAL_US later inside a
+// zone and ZSIM_REMOTE_US across zones. Bytes crossing zones are counted per
+// message type as they are sent, so probes, PING-REQs, pushes and piggyback
+// growth all show up. Each layout runs `secs` of steady state, then with
+// zone 0 failed as a whole until every other member holds all of it Dead.
+static constexpr uint64_t ZSIM_LOCAL_US  = 200;
+static constexpr uint64_t ZSIM_REMOTE_US = 2000;
+static constexpr uint64_t ZSIM_START_US  = 1000000000000ull;
+static constexpr uint64_t ZSIM_WARMUP_MS = 10000;
+static constexpr uint64_t ZSIM_LIMIT_MS  = 1800000;
+
+struct ZoneTraffic {
+    uint64_t cross[4] = {};     // probe, indirect, push, other
+    uint64_t total = 0;
+    uint64_t ms = 0;
+};
+
+struct ZoneSimResult {
+    ZoneTraffic steady;
+    ZoneTraffic failure;
+    size_t failed = 0;
+    uint64_t detect_ms = 0;     // 0 if not within ZSIM_LIMIT_MS
+};
+
+static size_t traffic_class(const std::string& msg) {
+    const std::string type = msg.substr(0, msg.find(' '));
+    if (type == "PING" || type == "ACK") return 0;
+    if (type.compare(0, 8, "PING-REQ") == 0 || type.compare(0, 7, "ACK-REQ") == 0) return 1;
+    if (type == "SUSPECT" || type == "ALIVE" || type == "CONFIRM" || type == "LEAVE") return 2;
+    return 3;
+}
+
+static ZoneSimResult run_zone_sim(size_t n, size_t zones, bool tagged, uint64_t secs) {
+    struct Ev {
+        uint64_t t_us;
+        uint64_t seq;
+        size_t to;
+        size_t from;
+        std::string msg;        // empty for a heartbeat tick
+        bool operator>(const Ev& o) const { return t_us != o.t_us ? t_us > o.t_us : seq > o.seq; }
+    };
+
+    uint64_t clock_us = ZSIM_START_US;
+    set_sim_clock_us(clock_us);
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<size_t> zone(n);
+    std::vector<bool> up(n, true);
+    std::vector<sockaddr_in> addr(n);
+    std::unordered_map<std::string, size_t> by_ip;
+
+    for (size_t i = 0; i < n; i++) {
+        auto node = std::make_unique<Node>(std::vector<std::string>{});
+        node->name = "zm-" + std::to_string(i);
+        node->ip = storm_ip(41, i + 1);
+        node->id = member_id(node->name, node->ip);
+        node->schedule.set_self(node->name);
+        node->incarnation = 1;
+        node->joined.store(true);
+        node->hb.attach(*node);
+        node->udpq.attach(*node);
+
+        zone[i] = i % zones;
+        by_ip[node->ip] = i;
+        addr[i].sin_family = AF_INET;
+        inet_pton(AF_INET, node->ip.c_str(), &addr[i].sin_addr);
+        nodes.push_back(std::move(node));
+    }
+
+    // Start from a converged view.
+    for (size_t i = 0; i < n; i++) {
+        Node& node = *nodes[i];
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        if (tagged) node.own_meta_[ZONE_KEY] = "z" + std::to_string(zone[i]);
+        for (size_t j = 0; j < n; j++) {
+            merge_member(node, nodes[j]->name, nodes[j]->ip, "1", MemberStatus::Alive, now_ms(), true);
+            MemberInfo& info = node.membership[nodes[j]->name];
+            if (i == j) info.has_coord = true;
+            if (!tagged) continue;
+            info.meta[ZONE_KEY] = "z" + std::to_string(zone[j]);
+            info.meta_version = (1ull << 32) | 1;
+            node.schedule.update(nodes[j]->name, &info);
+        }
+    }
+
+    std::priority_queue<Ev, std::vector<Ev>, std::greater<Ev>> q;
+    uint64_t seq = 0;
+    size_t current = 0;
+    ZoneTraffic* counting = nullptr;
+
+    std::mt19937 rng(45);
+    for (size_t i = 0; i < n; i++)
+        q.push({ clock_us + std::uniform_int_distribution<uint64_t>(0, TICK_MS * 1000 - 1)(rng), seq++, i, i, "" });
+
+    set_udp_tap([&](const std::string& ip, const std::string& msg) {
+        auto it = by_ip.find(ip);
+        if (it == by_ip.end()) return;
+        const size_t to = it->second;
+        const bool cross = zone[to] != zone[current];
+        if (counting) {
+            counting->total += msg.size();
+            if (cross) counting->cross[traffic_class(msg)] += msg.size();
+        }
+        if (up[to]) q.push({ clock_us + (cross ? ZSIM_REMOTE_US : ZSIM_LOCAL_US), seq++, to, current, msg });
+    });
+
+    auto run_until = [&](uint64_t end_us) {
+        while (!q.empty() && q.top().t_us < end_us) {
+            const Ev ev = q.top();
+            q.pop();
+            if (!up[ev.to]) continue;
+
+            clock_us = ev.t_us;
+            set_sim_clock_us(clock_us);
+            current = ev.to;
+            if (ev.msg.empty()) {
+                nodes[ev.to]->hb.tick(clock_us / 1000);
+                q.push({ ev.t_us + TICK_MS * 1000, seq++, ev.to, ev.to, "" });
+            } else {
+                nodes[ev.to]->udpq.handle_datagram(addr[ev.from], ev.msg);
+            }
+        }
+        clock_us = end_us;
+        set_sim_clock_us(clock_us);
+    };
+
+    ZoneSimResult r;
+
+    run_until(clock_us + ZSIM_WARMUP_MS * 1000);
+    counting = &r.steady;
+    run_until(clock_us + secs * 1000000);
+    r.steady.ms = secs * 1000;
+
+    std::vector<size_t> failed, alive;
+    for (size_t i = 0; i < n; i++) (zone[i] == 0 ? failed : alive).push_back(i);
+    for (size_t f : failed) up[f] = false;
+    r.failed = failed.size();
+
+    auto all_detected = [&] {
+        for (size_t s : alive) {
+            Node& node = *nodes[s];
+            std::lock_guard<std::mutex> lk(node.membership_mu);
+            for (size_t f : failed) {
+                auto it = node.membership.find(nodes[f]->name);
+                if (it != node.membership.end() && !is_gone(it->second.status)) return false;
+            }
+        }
+        return true;
+    };
+
+    counting = &r.failure;
+    const uint64_t failed_at = clock_us;
+    while (clock_us - failed_at < ZSIM_LIMIT_MS * 1000) {
+        run_until(clock_us + TICK_MS * 1000);
+        if (all_detected()) {
+            r.detect_ms = (clock_us - failed_at) / 1000;
+            break;
+        }
+    }
+    r.failure.ms = (clock_us - failed_at) / 1000;
+
+    set_udp_tap(nullptr);
+    set_sim_clock_us(0);
+    return r;
+}
+
+static int bench_zones(const std::vector<std::string>& args) {
+    const size_t n = std::max<size_t>(arg_or(args, 0, 240), 8);
+    const size_t zones = std::max<size_t>(arg_or(args, 1, 4), 2);
+    const uint64_t secs = std::max<size_t>(arg_or(args, 2, 60), 1);
+
+    // A member that refutes writes its incarnation file: keep the
+    // simulated ones away from a real node's.
+    char cwd[4096];
+    char dir[] = "/tmp/gds-bench-XXXXXX";
+    if (!getcwd(cwd, sizeof(cwd)) || !mkdtemp(dir) || chdir(dir) != 0) {
+        perror("bench zones: scratch directory");
+        return 1;
+    }
+
+    auto kbps = [](uint64_t bytes, uint64_t ms) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.2f", ms ? (double)bytes / 1024.0 / ((double)ms / 1000.0) : 0.0);
+        return std::string(buf);
+    };
+
+    std::vector<std::vector<std::string>> rows;
+    for (bool tagged : { false, true }) {
+        const ZoneSimResult r = run_zone_sim(n, zones, tagged, secs);
+
+        for (const ZoneTraffic* t : { &r.steady, &r.failure }) {
+            const bool failure = t == &r.failure;
+            const uint64_t cross = t->cross[0] + t->cross[1] + t->cross[2] + t->cross[3];
+            std::string detect = "-";
+            if (failure) detect = r.detect_ms ? std::to_string(r.detect_ms / 1000) : ">" + std::to_string(ZSIM_LIMIT_MS / 1000);
+
+            rows.push_back({
+                tagged ? "zoned" : "flat",
+                failure ? "zone failed" : "steady",
+                std::to_string(t->ms / 1000),
+                kbps(cross, t->ms),
+                kbps(t->cross[0], t->ms),
+                kbps(t->cross[1], t->ms),
+                kbps(t->cross[2], t->ms),
+                kbps(t->cross[3], t->ms),
+                kbps(t->total, t->ms),
+                detect
+            });
+        }
+    }
+
+    std::remove(INCARNATION_PATH);
+    rmdir(dir);
+    if (chdir(cwd) != 0) perror("bench zones: chdir");
+
+    std::cout << "zones: " << n << " members in " << zones << " zones on virtual time, TICK_MS=" << TICK_MS
+              << ", " << ZONE_REPRESENTATIVES << " representatives per zone, ZONE_SAMPLE_EVERY="
+              << ZONE_SAMPLE_EVERY << "\n"
+              << "KB/s of UDP payload sent across zones by type (PROBE = PING/ACK, INDIRECT = PING-REQ\n"
+              << "and ACK-REQ legs, PUSH = SUSPECT/ALIVE/CONFIRM/LEAVE); DETECT_S is how long until every\n"
+              << "live member holds all " << (n + zones - 1) / zones << " members of the failed zone Dead\n";
+    print_table({ "LAYOUT", "PHASE", "SECS", "CROSS_KBPS", "PROBE", "INDIRECT", "PUSH", "OTHER",
+                  "ALL_KBPS", "DETECT_S" }, rows);
+    return 0;
+}
+
+// The old per-tick probe pool: scan the view for expired timers, collect,
+// sort and compare the pool, reshuffle it on any change, take the next.
+static size_t rebuild_tick(const Node& node, std::vector<std::string>& pool, size_t& idx,
+                           std::mt19937& rng, uint64_t now) {
+    size_t due = 0;
+    std::vector<std::string> names;
+    for (const auto& [name, info] : node.membership) {
+        if (name == node.name) continue;
+        if (info.status == MemberStatus::Suspect && now - info.suspect_since_ms > SUSPECT_MS) due++;
+        if (info.status == MemberStatus::Dead && now - info.dead_since_ms >= DEAD_RETAIN_MS) due++;
+        if (info.status != MemberStatus::Dead && !info.ip.empty()) names.push_back(name);
+    }
+
+    std::sort(names.begin(), names.end());
+    std::vector<std::string> sorted = pool;
+    std::sort(sorted.begin(), sorted.end());
+    if (names != sorted) {
+        pool = std::move(names);
+        idx = 0;
+        std::shuffle(pool.begin(), pool.end(), rng);
+    }
+
+    if (idx >= pool.size()) {
+        idx = 0;
+        std::shuffle(pool.begin(), pool.end(), rng);
+    }
+    return pool.empty() ? due : due + pool[idx++].size();
+}
+
+static size_t schedule_tick(Node& node, std::mt19937& rng, uint64_t now) {
+    size_t due = node.schedule.suspects().started_before(now - SUSPECT_MS).size() +
+                 node.schedule.dead().started_before(now - DEAD_RETAIN_MS + 1).size();
+    if (const std::string* t = node.schedule.local().next(rng)) due += t->size();
+    if (const std::string* t = node.schedule.remote().next(rng)) due += t->size();
+    return due;
+}
+
+// Heartbeat tick cost of picking probe targets and finding expired timers
+// as the view grows: the old full rebuild against the incremental
+// ProbeSchedule. "churn" flips one member between Alive and Dead every
+// tick, which made the old pool reshuffle; both sides pay the same
+// on_member_change for it.
+static int bench_probes(const std::vector<std::string>& args) {
+    const size_t max_n = std::max<size_t>(arg_or(args, 0, 100000), 100);
+    const size_t ticks = std::max<size_t>(arg_or(args, 1, 100), 2);
+
+    std::vector<std::vector<std::string>> rows;
+    auto fmt = [](double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.2f", v);
+        return std::string(buf);
+    };
+
+    std::mt19937 rng(47);
+    size_t sink = 0;
+
+    for (size_t n = 100; n <= max_n; n *= 10) {
+        Node node({});
+        const uint64_t now = now_ms();
+        std::unique_lock<std::mutex> lk(node.membership_mu);
+
+        for (size_t i = 0; i < n; i++) {
+            const std::string name = "member-" + std::to_string(i);
+            const std::string ip = "10.40." + std::to_string((i >> 8) & 255) + "." + std::to_string(i & 255);
+            merge_member(node, name, ip, "1", MemberStatus::Alive, now, true);
+        }
+
+        auto flip = [&](size_t t) {
+            MemberInfo& info = node.membership["member-0"];
+            const MemberState before = state_of(info);
+            info.status = t % 2 ? MemberStatus::Dead : MemberStatus::Alive;
+            info.dead_since_ms = now;
+            node.on_member_change("member-0", before, &info);
+        };
+
+        for (bool churn : { false, true }) {
+            std::vector<std::string> pool;
+            size_t idx = 0;
+            sink += rebuild_tick(node, pool, idx, rng, now);
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t t = 0; t < ticks; t++) {
+                if (churn) flip(t);
+                sink += rebuild_tick(node, pool, idx, rng, now);
+            }
+            const double rebuild_us = elapsed_us(t0) / (double)ticks;
+
+            t0 = std::chrono::steady_clock::now();
+            for (size_t t = 0; t < ticks; t++) {
+                if (churn) flip(t);
+                sink += schedule_tick(node, rng, now);
+            }
+            const double schedule_us = elapsed_us(t0) / (double)ticks;
+
+            // The PING each tick sends: piggyback entries, metadata, digest.
+            lk.unlock();
+            t0 = std::chrono::steady_clock::now();
+            for (size_t t = 0; t < ticks; t++)
+                sink += build_piggy_data(node, "member-1", PIGGY_K).size();
+            const double ping_us = elapsed_us(t0) / (double)ticks;
+            lk.lock();
+
+            rows.push_back({
+                std::to_string(n),
+                churn ? "churn" : "steady",
+                fmt(rebuild_us),
+                fmt(schedule_us),
+                fmt(rebuild_us / std::max(schedule_us, 0.01)),
+                fmt(ping_us)
+            });
+        }
+    }
+    (void)sink;
+
+    std::cout << "probes: per-tick cost of choosing probe targets and expiring timers, and of\n"
+              << "building one PING piggyback, " << ticks << " ticks per row\n";
+    print_table({ "MEMBERS", "VIEW", "REBUILD_US", "SCHEDULE_US", "SPEEDUP", "PING_US" }, rows);
+    return 0;
+}
+
+int run_bench(const std::string& name, const std::vector<std::string>& args) {
+    if (name == "churn") return bench_churn(args);
+    if (name == "joinstorm") return bench_joinstorm(args);
+    if (name == "overload") return bench_overload(args);
+    if (name == "dissemination") return bench_dissemination(args);
+    if (name == "ring") return bench_ring(args);
+    if (name == "vivaldi") return bench_vivaldi(args);
+    if (name == "wire") return bench_wire(args);
+    if (name == "logging") return bench_logging(args);
+    if (name == "shm") return bench_shm(args);
+    if (name == "zones") return bench_zones(args);
+    if (name == "probes") return bench_probes(args);
+
+    std::cerr << "Unknown benchmark: " << name << "\n"
+              << "Available: churn [cycles] [step_ms]\n"
+              << "           joinstorm [joiners] [seeds] [spread_ms] [existing]\n"
+              << "           overload [seconds] [rate]\n"
+              << "           dissemination [max_nodes] [trials]\n"
+              << "           ring [max_members] [lookups]\n"
+              << "           vivaldi [members] [racks] [periods]\n"
+              << "           wire [members] [datagram_bytes]\n"
+              << "           logging [items] [sink_stall_ms]\n"
+              << "           shm [members] [readers]\n"
+              << "           zones [members] [zones] [seconds]\n"
+              << "           probes [max_members] [ticks]\n";
+    return 2;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Offline benchmarks, run as `gds bench <name> [args...]`.
+int run_bench(const std::string& name, const std::vector<std::string>& args);
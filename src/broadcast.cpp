@@ -0,0 +1,166 @@
+#include "broadcast.h"
+
+#include <algorithm>
+#include <random>
+
+#include "hash_util.h"
+#include "membership.h"
+#include "membership_config.h"
+#include "node.h"
+#include "sender.h"
+#include "string_util.h"
+#include "time_util.h"
+
+std::string encode_broadcast(const BroadcastMessage& m) {
+    std::string out = to_hex(m.id);
+    out.push_back(':');
+    percent_encode(out, m.origin);
+    out.push_back(':');
+    out += std::to_string(m.origin_wall_ms);
+    out.push_back(':');
+    percent_encode(out, m.payload);
+    return out;
+}
+
+bool decode_broadcast(const std::string& s, BroadcastMessage& m) {
+    const size_t c1 = s.find(':');
+    const size_t c2 = (c1 == std::string::npos) ? std::string::npos : s.find(':', c1 + 1);
+    const size_t c3 = (c2 == std::string::npos) ? std::string::npos : s.find(':', c2 + 1);
+    if (c3 == std::string::npos) return false;
+
+    if (!parse_hex(s.substr(0, c1), m.id)) return false;
+    if (!percent_decode(s, c1 + 1, c2, m.origin) || m.origin.empty()) return false;
+    try { m.origin_wall_ms = std::stoull(s.substr(c2 + 1, c3 - c2 - 1)); } catch (...) { return false; }
+    return percent_decode(s, c3 + 1, s.size(), m.payload) && m.payload.size() <= BCAST_MAX_BYTES;
+}
+
+void Broadcaster::on_deliver(BroadcastHandler h) {
+    std::lock_guard<std::mutex> lk(handlers_mu_);
+    handlers_.push_back(std::move(h));
+}
+
+bool Broadcaster::mark_seen_locked(uint64_t id) {
+    if (!seen_.insert(id).second) return false;
+
+    seen_order_.push_back(id);
+    if (seen_order_.size() > BCAST_SEEN_MAX) {
+        seen_.erase(seen_order_.front());
+        seen_order_.pop_front();
+    }
+    return true;
+}
+
+void Broadcaster::record_locked(const BroadcastMessage& m, bool pushed, bool first) {
+    if (first) {
+        BroadcastStat st;
+        st.id = m.id;
+        st.origin = m.origin;
+        const uint64_t wall = wall_ms();
+        st.latency_ms = wall > m.origin_wall_ms ? wall - m.origin_wall_ms : 0;
+        stats_.push_back(std::move(st));
+        if (stats_.size() > BCAST_STATS_MAX) stats_.pop_front();
+    }
+
+    for (auto it = stats_.rbegin(); it != stats_.rend(); ++it) {
+        if (it->id != m.id) continue;
+        it->receives++;
+        if (pushed) it->pushes++;
+        break;
+    }
+}
+
+void Broadcaster::spread(Node& node, const BroadcastMessage& m, const std::string& encoded) {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        queue_.push_back({ m.id, encoded, 0 });
+        if (queue_.size() > BCAST_QUEUE_MAX) queue_.pop_front();
+    }
+
+    // Push to FANOUT random alive members other than us and the origin.
+    static thread_local std::mt19937 rng(std::random_device{}());
+    std::vector<std::string> targets;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        std::vector<std::string> sample;
+        node.schedule.known().sample(2 * FANOUT, rng, sample);
+        for (const auto& name : sample) {
+            if (targets.size() == FANOUT) break;
+            if (name == m.origin) continue;
+            auto it = node.membership.find(name);
+            if (it != node.membership.end() && it->second.status == MemberStatus::Alive)
+                targets.push_back(it->second.ip);
+        }
+    }
+
+    const std::string msg = make_msg("BCAST", node, encoded);
+    for (const auto& ip : targets) send_udp(ip, msg);
+
+    std::vector<BroadcastHandler> handlers;
+    {
+        std::lock_guard<std::mutex> lk(handlers_mu_);
+        handlers = handlers_;
+    }
+    for (const auto& h : handlers) h(m);
+}
+
+bool Broadcaster::send(Node& node, const std::string& payload) {
+    if (payload.empty() || payload.size() > BCAST_MAX_BYTES) return false;
+
+    BroadcastMessage m;
+    m.origin = node.name;
+    m.origin_wall_ms = wall_ms();
+    m.payload = payload;
+
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        m.id = mix64(fnv1a64(node.name) ^ mix64(node.incarnation.load() << 32 | ++next_seq_));
+        mark_seen_locked(m.id);
+        record_locked(m, false, true);
+    }
+
+    spread(node, m, encode_broadcast(m));
+    return true;
+}
+
+void Broadcaster::receive(Node& node, const std::string& encoded, bool pushed) {
+    BroadcastMessage m;
+    if (!decode_broadcast(encoded, m)) return;
+
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        const bool first = mark_seen_locked(m.id);
+        record_locked(m, pushed, first);
+        if (!first) return;
+    }
+
+    spread(node, m, encoded);
+}
+
+std::string Broadcaster::piggy_field(size_t members, size_t max_bytes) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (queue_.empty()) return "";
+
+    auto best = queue_.begin();
+    for (auto it = queue_.begin(); it != queue_.end(); ++it)
+        if (it->sent < best->sent) best = it;
+
+    // Pushes already reach most members; piggybacks only mop up, so one
+    // round of log2(N) suffices.
+    const size_t limit = std::max<size_t>(retransmit_limit(members) / DISSEMINATE_MULT, 1);
+
+    if (best->encoded.size() + 2 > max_bytes) return "";
+
+    std::string field = "B=" + best->encoded;
+    if (++best->sent >= limit) queue_.erase(best);
+    return field;
+}
+
+std::vector<BroadcastStat> Broadcaster::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return { stats_.begin(), stats_.end() };
+}
+
+void Broadcaster::reset() {
+    std::lock_guard<std::mutex> lk(mu_);
+    queue_.clear();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Node;
+
+// Cluster-wide application events. A message spreads two ways: pushed as
+// BCAST to FANOUT random members by each node on first receipt, and carried
+// as a trailer field on PING/ACK/JOIN/WELCOME until it has been piggybacked
+// ceil(log2(N + 1)) times:
+//
+//   B=<id>:<origin>:<origin wall ms>:<payload>
+//
+// (origin and payload percent-escaped). Duplicates are dropped against a
+// bounded FIFO of seen ids.
+
+inline constexpr size_t BCAST_MAX_BYTES = 256;   // payload
+inline constexpr size_t BCAST_SEEN_MAX  = 4096;
+inline constexpr size_t BCAST_QUEUE_MAX = 64;    // messages being piggybacked
+inline constexpr size_t BCAST_STATS_MAX = 32;    // messages kept for `broadcast stats`
+
+struct BroadcastMessage {
+    uint64_t id = 0;
+    std::string origin;
+    uint64_t origin_wall_ms = 0;
+    std::string payload;
+};
+
+struct BroadcastStat {
+    uint64_t id = 0;
+    std::string origin;
+    uint64_t latency_ms = 0;   // origin send to first delivery here (wall clocks)
+    uint64_t receives = 0;     // copies received, including the first
+    uint64_t pushes = 0;       // copies that came as BCAST rather than piggyback
+};
+
+using BroadcastHandler = std::function<void(const BroadcastMessage&)>;
+
+class Broadcaster {
+public:
+    // Handlers run on the thread that delivered the message, without locks.
+    void on_deliver(BroadcastHandler h);
+
+    // Delivers locally, then pushes and queues for piggybacking.
+    bool send(Node& node, const std::string& payload);
+
+    // An encoded message from a peer (`pushed`: it came as BCAST).
+    void receive(Node& node, const std::string& encoded, bool pushed);
+
+    // The B= field for the next piggyback, or "" if none is queued or the
+    // next one would exceed `max_bytes` (it then stays queued uncounted).
+    // Safe under membership_mu.
+    std::string piggy_field(size_t members, size_t max_bytes);
+
+    std::vector<BroadcastStat> stats() const;
+    void reset();
+
+private:
+    struct Pending {
+        uint64_t id = 0;
+        std::string encoded;
+        size_t sent = 0;
+    };
+
+    bool mark_seen_locked(uint64_t id);
+    void record_locked(const BroadcastMessage& m, bool pushed, bool first);
+    void spread(Node& node, const BroadcastMessage& m, const std::string& encoded);
+
+    mutable std::mutex mu_;
+    uint64_t next_seq_ = 0;
+
+    std::unordered_set<uint64_t> seen_;
+    std::deque<uint64_t> seen_order_;
+
+    std::deque<Pending> queue_;
+
+    std::deque<BroadcastStat> stats_;
+
+    std::mutex handlers_mu_;
+    std::vector<BroadcastHandler> handlers_;
+};
+
+std::string encode_broadcast(const BroadcastMessage& m);
+bool decode_broadcast(const std::string& s, BroadcastMessage& m);
@@ -3,14 +3,19 @@
 #include <iostream>
 #include <algorithm>
 #include <string>
-#include <thread>
 #include <chrono>
-#include <termios.h>
-#include <unistd.h>
-#include <fcntl.h>
 
+#include "faults.h"
+#include "hash_util.h"
+#include "live_view.h"
+#include "log.h"
+#include "measure.h"
+#include "net_util.h"
 #include "node.h"
+#include "string_util.h"
 #include "table_print.h"
+#include "trace.h"
+#include "zones.h"
 
 void help() {
     std::cout
@@ -19,8 +24,29 @@ void help() {
         << "  info            - show this node's info (name, IP, status)\n"
         << "  start           - start networking + background join attempts\n"
         << "  stop            - stop networking + background threads\n"
-        << "  list [live]     - list all known members; add 'live' to make it an updating table\n"
+        << "  list [live]     - list all known members; 'live' opens a paged, updating view\n"
+        << "  list live [state=alive|suspect|dead|left|down] [prefix=<p>] [sort=name|state|inc|ip]\n"
         << "  ping <target>   - send a ping to the given IP or hostname\n"
+        << "  measure         - collect status transitions from all members and report detection/join latency\n"
+        << "  trace dump [file] - write the protocol flight recorder to a file (default trace.bin)\n"
+        << "  trace on|off    - enable or disable flight recording\n"
+        << "  log [level debug|info|warn|error|off] [file <path>|-] - show or change background logging\n"
+        << "  fault [out|in|both <ip|*> [drop=P] [delay=MS] [jitter=MS] [dup=P] [reorder=P] [block]]\n"
+        << "                  - inject UDP faults per peer and direction; 'fault' shows rules and counters\n"
+        << "  fault clear [out|in|both <ip|*>] | fault seed <n> - remove rules / reseed fault decisions\n"
+        << "  queue [reset]   - show UDP queue lanes (depth, drops, wait); 'reset' clears counters\n"
+        << "  queue policy oldest|lowest - what to drop when the UDP queue is full\n"
+        << "  meta [name]     - show this node's (or a member's) metadata\n"
+        << "  meta set <key> <value> | meta del <key> - change this node's metadata\n"
+        << "  tagged <key>[=<value>] - list alive members carrying a metadata tag\n"
+        << "  zones           - members per zone (metadata tag 'zone') and each zone's representatives\n"
+        << "  owner <key> [n] - alive member owning <key> on the consistent-hash ring, or n replicas\n"
+        << "  nearest [n] [member] - n alive members closest to this node (or member) by estimated RTT\n"
+        << "  events [n]      - last n membership change events (stream them with 'gds events <ip> [seq]')\n"
+        << "  discovery [on [group[:port]] | off] - multicast discovery status, or turn it on/off\n"
+        << "  reprobe [<ms> | off] - how often Dead and tombstoned members are pinged to heal partitions\n"
+        << "  broadcast <msg> - send an event to every member\n"
+        << "  broadcasts      - recent broadcasts: delivery latency and duplicate receives\n"
         << "  quit, exit      - exit the program\n";
 }
 
@@ -36,6 +62,22 @@ void info(const Node& node) {
     const std::string role_str   = (seed ? "Seed" : "Node");
     const std::string inc_str    = std::to_string(node.incarnation);
     const std::string status_str = (running ? "Running" : "Not running");
+    const std::string digest_str = to_hex(node.view_digest.load());
+    const std::string id_str     = "#" + node.id;
+
+    size_t peers = 0, compact = 0;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        for (const auto& [name, m] : node.membership) {
+            if (name == node.name) continue;
+            peers++;
+            if (speaks_ids(m)) compact++;
+        }
+    }
+    const std::string compact_str = std::to_string(compact) + " of " + std::to_string(peers) + " peers";
+    const std::string shm_str = node.shm.active()
+        ? node.shm.name() + " (" + std::to_string(node.shm.publishes()) + " publishes)"
+        : "Not published";
 
     std::string joined_str =
         seed ? "Yes" :
@@ -44,7 +86,9 @@ void info(const Node& node) {
 
     const size_t max_len = std::max({
         name_str.size(), ip_str.size(), role_str.size(),
-        inc_str.size(), status_str.size(), joined_str.size()
+        inc_str.size(), status_str.size(), joined_str.size(),
+        digest_str.size(), id_str.size(), compact_str.size(),
+        shm_str.size()
     });
 
     const size_t label_w = 11;
@@ -81,6 +125,10 @@ void info(const Node& node) {
     row("Status",      status_str);
     row("Joined",      joined_str);
     row("Incarnation", inc_str);
+    row("View digest", digest_str);
+    row("Member ID",   id_str);
+    row("Compact IDs", compact_str);
+    row("Shared view", shm_str);
 
     border();
 }
@@ -90,6 +138,7 @@ static const char* status_str(MemberStatus s) {
         case MemberStatus::Alive:   return "Alive";
         case MemberStatus::Suspect: return "Suspect";
         case MemberStatus::Dead:    return "Dead";
+        case MemberStatus::Left:    return "Left";
         default:                    return "Unknown";
     }
 }
@@ -117,71 +166,406 @@ void list_members(const Node& node) {
     print_table(headers, rows);
 }
 
-static termios oldt;
-static bool saved_term = false;
+void trace_command(const std::string& args) {
+    std::string sub, rest;
+    split_cmd_args(args, sub, rest);
 
-void set_nonblocking(bool enable) {
-    if (enable) {
-        if (!saved_term) {
-            tcgetattr(STDIN_FILENO, &oldt);
-            saved_term = true;
+    if (sub == "dump") {
+        const std::string path = rest.empty() ? "trace.bin" : rest;
+        size_t n = 0;
+        if (trace_dump(path, &n)) {
+            std::cout << "Wrote " << n << " events to " << path
+                      << " (decode with: gds trace " << path << ")\n";
+        } else {
+            std::cout << "Could not write " << path << "\n";
         }
-        termios newt = oldt;
-        newt.c_lflag &= ~(ICANON | ECHO);
-        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+        return;
+    }
 
-        int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
-        fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
-    } else if (saved_term) {
-        tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-        int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
-        fcntl(STDIN_FILENO, F_SETFL, flags & ~O_NONBLOCK);
+    if (sub == "on" || sub == "off") {
+        trace_set_enabled(sub == "on");
+        std::cout << "Flight recorder " << (sub == "on" ? "enabled" : "disabled") << ".\n";
+        return;
     }
+
+    std::cout << "Usage: trace dump [file] | trace on | trace off\n";
 }
 
-void live_list_members(const Node& node) {
-    set_nonblocking(true);
+void log_command(const std::string& args) {
+    std::string sub, rest;
+    split_cmd_args(args, sub, rest);
 
-    const int refresh_ms = 1000;
-    std::atomic<bool> running{true};
-    size_t prev_height = 0;
+    if (sub == "level") {
+        LogLevel lvl;
+        if (!log_level_from_name(rest, lvl)) {
+            std::cout << "Usage: log level debug|info|warn|error|off\n";
+            return;
+        }
+        log_set_level(lvl);
+    } else if (sub == "file") {
+        if (!log_set_file(rest)) {
+            std::cout << "Could not open " << rest << "\n";
+            return;
+        }
+    } else if (!sub.empty()) {
+        std::cout << "Usage: log [level <level>] [file <path>|-]\n";
+        return;
+    }
 
-    std::vector<std::string> headers = {"NAME", "STATE  ", "IPV4", "LAST_SEEN_MS", "INC"};
+    const LogStats st = log_stats();
+    std::cout << "Level " << log_level_name(log_level()) << ", writing to " << log_file() << "\n"
+              << "  written " << st.written << ", dropped " << st.dropped
+              << " (ring full), suppressed " << st.suppressed << " (rate limit)\n";
+}
+
+static const char* fault_dir_name(FaultDir d) {
+    return d == FaultDir::Out ? "out" : "in";
+}
+
+static bool parse_fault_dirs(const std::string& s, std::vector<FaultDir>& out) {
+    if (s == "out") out = { FaultDir::Out };
+    else if (s == "in") out = { FaultDir::In };
+    else if (s == "both") out = { FaultDir::Out, FaultDir::In };
+    else return false;
+    return true;
+}
+
+void fault_command(const std::string& args) {
+    const std::vector<std::string> words = split_ws(args);
+    std::vector<FaultDir> dirs;
+
+    if (words.size() >= 1 && words[0] == "clear") {
+        if (words.size() == 1) {
+            fault_clear_all();
+            std::cout << "All fault rules removed.\n";
+        } else if (words.size() == 3 && parse_fault_dirs(words[1], dirs)) {
+            for (FaultDir d : dirs) fault_clear(d, words[2]);
+            std::cout << "Removed.\n";
+        } else {
+            std::cout << "Usage: fault clear [out|in|both <ip|*>]\n";
+        }
+        return;
+    }
+
+    if (words.size() == 2 && words[0] == "seed") {
+        try {
+            fault_seed(std::stoull(words[1]));
+            std::cout << "Fault seed " << words[1] << ".\n";
+        } catch (...) {
+            std::cout << "Usage: fault seed <n>\n";
+        }
+        return;
+    }
+
+    if (!words.empty()) {
+        std::string settings;
+        for (size_t i = 2; i < words.size(); i++) settings += words[i] + " ";
+
+        FaultRule rule;
+        if (words.size() < 3 || !parse_fault_dirs(words[0], dirs) ||
+            (words[1] != "*" && !is_valid_ipv4(words[1])) || !parse_fault_rule(settings, rule)) {
+            std::cout << "Usage: fault out|in|both <ip|*> [drop=P] [delay=MS] [jitter=MS] [dup=P] [reorder=P] [block]\n";
+            return;
+        }
+        for (FaultDir d : dirs) fault_set(d, words[1], rule);
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& e : fault_rules())
+        rows.push_back({ fault_dir_name(e.dir), e.peer, fault_rule_str(e.rule) });
+    print_table({ "DIR", "PEER", "RULE" }, rows);
+
+    for (FaultDir d : { FaultDir::Out, FaultDir::In }) {
+        const FaultStats st = fault_stats(d);
+        std::cout << fault_dir_name(d) << ": passed " << st.passed << ", dropped " << st.dropped
+                  << ", blocked " << st.blocked << ", delayed " << st.delayed
+                  << ", duplicated " << st.duplicated << ", reordered " << st.reordered << "\n";
+    }
+}
+
+void queue_command(Node& node, const std::string& args) {
+    std::string sub, rest;
+    split_cmd_args(args, sub, rest);
+
+    if (sub == "policy") {
+        if (rest == "oldest") node.udpq.set_policy(OverloadPolicy::DropOldest);
+        else if (rest == "lowest") node.udpq.set_policy(OverloadPolicy::DropLowest);
+        else { std::cout << "Usage: queue policy oldest|lowest\n"; return; }
+        std::cout << "UDP queue overload policy: drop-" << rest << "\n";
+        return;
+    }
+
+    if (sub == "reset") {
+        node.udpq.reset_stats();
+        std::cout << "UDP queue counters reset.\n";
+        return;
+    }
+
+    if (!sub.empty()) {
+        std::cout << "Usage: queue [reset] | queue policy oldest|lowest\n";
+        return;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (size_t i = 0; i < UDP_LANES; i++) {
+        const UdpLaneStats st = node.udpq.lane_stats((UdpLane)i);
+        rows.push_back({
+            udp_lane_name((UdpLane)i),
+            std::to_string(st.depth),
+            std::to_string(st.max_depth),
+            std::to_string(st.arrived),
+            std::to_string(st.dropped),
+            std::to_string(st.wait_p50_us),
+            std::to_string(st.wait_p99_us),
+            std::to_string(st.wait_max_us)
+        });
+    }
+
+    std::cout << "Policy: drop-" << (node.udpq.policy() == OverloadPolicy::DropOldest ? "oldest" : "lowest")
+              << ", capacity " << UDPQ_CAPACITY << "\n";
+    print_table({ "LANE", "DEPTH", "MAX_DEPTH", "ARRIVED", "DROPPED", "WAIT_P50_US", "WAIT_P99_US", "WAIT_MAX_US" }, rows);
+}
+
+void meta_command(Node& node, const std::string& args) {
+    std::string sub, rest;
+    split_cmd_args(args, sub, rest);
+
+    if (sub == "set") {
+        std::string key, value;
+        split_cmd_args(rest, key, value);
+        if (key.empty()) { std::cout << "Usage: meta set <key> <value>\n"; return; }
+        if (!node.set_meta(key, value))
+            std::cout << "Metadata limit reached (" << META_MAX_KEYS << " keys, "
+                      << META_MAX_BYTES << " bytes encoded).\n";
+        return;
+    }
+
+    if (sub == "del") {
+        if (!node.erase_meta(rest)) std::cout << "No such key: " << rest << "\n";
+        return;
+    }
+
+    Meta meta;
+    uint64_t version = 0;
+
+    if (sub.empty()) {
+        meta = node.own_meta();
+    } else {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        auto it = node.membership.find(sub);
+        if (it == node.membership.end()) { std::cout << "Unknown member: " << sub << "\n"; return; }
+        meta = it->second.meta;
+        version = it->second.meta_version;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& [k, v] : meta) rows.push_back({ k, v });
+
+    if (!sub.empty()) std::cout << sub << " metadata, version " << version << "\n";
+    print_table({ "KEY", "VALUE" }, rows);
+}
+
+void tagged_command(Node& node, const std::string& args) {
+    if (args.empty()) { std::cout << "Usage: tagged <key>[=<value>]\n"; return; }
+
+    const size_t eq = args.find('=');
+    const std::string key = args.substr(0, eq);
+    const std::string value = eq == std::string::npos ? "" : args.substr(eq + 1);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::string> names = members_with_tag(node, key, eq == std::string::npos ? nullptr : &value);
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    for (const auto& n : names) std::cout << n << "\n";
+    std::cout << names.size() << " alive member(s), " << us << " us\n";
+}
+
+void broadcasts_command(const Node& node) {
+    std::vector<std::vector<std::string>> rows;
+    uint64_t receives = 0, redundant = 0;
+
+    for (const auto& st : node.broadcasts.stats()) {
+        receives += st.receives;
+        redundant += st.receives ? st.receives - 1 : 0;
+        rows.push_back({
+            to_hex(st.id),
+            st.origin,
+            std::to_string(st.latency_ms),
+            std::to_string(st.receives),
+            std::to_string(st.receives ? st.receives - 1 : 0),
+            std::to_string(st.pushes)
+        });
+    }
+
+    print_table({ "ID", "ORIGIN", "LATENCY_MS", "RECEIVES", "REDUNDANT", "PUSHED" }, rows);
+    std::cout << rows.size() << " message(s), " << redundant << " redundant of " << receives << " receives\n";
+}
+
+void owner_command(Node& node, const std::string& args) {
+    std::string key, n_str;
+    split_cmd_args(args, key, n_str);
+    if (key.empty()) { std::cout << "Usage: owner <key> [n]\n"; return; }
+
+    size_t n = 1;
+    if (!n_str.empty()) {
+        try { n = std::max<size_t>(std::stoul(n_str), 1); } catch (...) { n = 1; }
+    }
+
+    std::vector<std::string> owners;
+    size_t members = 0;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        owners = node.ring.replicas(key, n);
+        members = node.ring.members();
+    }
+
+    if (owners.empty()) { std::cout << "Ring is empty.\n"; return; }
+    for (size_t i = 0; i < owners.size(); i++)
+        std::cout << (i == 0 ? "owner   " : "replica ") << owners[i] << "\n";
+    std::cout << "(" << members << " alive members on the ring)\n";
+}
+
+void nearest_command(Node& node, const std::string& args) {
+    std::string n_str, to;
+    split_cmd_args(args, n_str, to);
 
-    while (running) {
-        std::vector<std::vector<std::string>> rows;
-
-        {
-            std::lock_guard<std::mutex> lk(node.membership_mu);
-            for (const auto& [name, info] : node.membership) {
-                std::string shown_name = (name == node.name) ? (name + " *") : name;
-                rows.push_back({
-                    shown_name,
-                    status_str(info.status),
-                    info.ip,
-                    std::to_string(info.last_seen_ms),
-                    std::to_string(info.incarnation)
-                });
-            }
+    size_t n = 5;
+    if (!n_str.empty()) {
+        try { n = std::max<size_t>(std::stoul(n_str), 1); } catch (...) { n = 5; }
+    }
+    if (to.empty()) to = node.name;
+
+    Coord from;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        auto it = node.membership.find(to);
+        if (it == node.membership.end() || !it->second.has_coord) {
+            std::cout << "No coordinate for " << to << ".\n";
+            return;
+        }
+        from = it->second.coord;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    char buf[32];
+    for (const auto& [name, ms] : nearest_members(node, to, n)) {
+        snprintf(buf, sizeof(buf), "%.3f", ms);
+        rows.push_back({ name, buf });
+    }
+
+    snprintf(buf, sizeof(buf), "%.3f", from.error);
+    std::cout << to << ": coordinate error " << buf;
+    snprintf(buf, sizeof(buf), "%.3f", from.height);
+    std::cout << ", height " << buf << " ms\n";
+    print_table({ "NAME", "EST_RTT_MS" }, rows);
+}
+
+void events_command(const Node& node, const std::string& args) {
+    size_t n = 20;
+    if (!args.empty()) {
+        try { n = std::max<size_t>(std::stoul(args), 1); } catch (...) { n = 20; }
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& e : node.events.recent(n)) {
+        rows.push_back({
+            std::to_string(e.seq),
+            member_event_name(e.kind),
+            e.name,
+            e.ip.empty() ? "-" : e.ip,
+            std::to_string(e.incarnation),
+            std::string(1, e.status),
+            std::to_string(e.wall_ms)
+        });
+    }
+
+    print_table({ "SEQ", "EVENT", "NAME", "IPV4", "INC", "STATE", "WALL_MS" }, rows);
+    std::cout << "last seq " << node.events.last_seq() << "\n";
+}
+
+void zones_command(const Node& node) {
+    const Meta own = node.own_meta();
+    auto z = own.find(ZONE_KEY);
+    const std::string my_zone = z == own.end() ? "" : z->second;
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& s : zone_summaries(node)) {
+        std::string reps;
+        for (const auto& r : s.representatives) reps += (reps.empty() ? "" : ",") + r;
+        rows.push_back({
+            (s.zone.empty() ? "(none)" : s.zone) + (s.zone == my_zone ? " *" : ""),
+            std::to_string(s.alive),
+            std::to_string(s.suspect),
+            std::to_string(s.dead),
+            reps.empty() ? "-" : reps
+        });
+    }
+    print_table({ "ZONE", "ALIVE", "SUSPECT", "DEAD", "REPRESENTATIVES" }, rows);
+}
+
+void discovery_command(Node& node, const std::string& args) {
+    std::string sub, rest;
+    split_cmd_args(args, sub, rest);
+
+    if (sub == "on") {
+        DiscoveryConfig cfg;
+        if (!rest.empty() && !parse_discovery_addr(rest, cfg)) {
+            std::cout << "Usage: discovery on [group[:port]] (an IPv4 multicast group)\n";
+            return;
         }
+        node.discovery.stop();
+        node.discovery.configure(cfg);
+        if (node.running.load()) node.discovery.start(node);
+    } else if (sub == "off") {
+        node.discovery.stop();
+        node.discovery.disable();
+    } else if (!sub.empty()) {
+        std::cout << "Usage: discovery [on [group[:port]] | off]\n";
+        return;
+    }
 
-        print_table_live(headers, rows, prev_height);
+    if (!node.discovery.enabled()) {
+        std::cout << "Discovery off.\n";
+        return;
+    }
 
-        std::cout << "Press 'q' to quit live view...\n" << std::flush;
+    const DiscoveryConfig cfg = node.discovery.config();
+    const DiscoveryStats st = node.discovery.stats();
+    std::cout << "Discovery on " << cfg.group << ":" << cfg.port
+              << (node.discovery.running() ? "" : " (not running)") << "\n"
+              << "  announces " << st.announces << ", received " << st.received
+              << ", replies " << st.replies << ", rate limited " << st.rate_limited
+              << (st.bootstrapped ? ", started a new cluster" : "") << "\n";
+}
 
-        char c = 0;
-        if (read(STDIN_FILENO, &c, 1) == 1) {
-            if (c == 'q' || c == 'Q') {
-                running = false;
-                break;
-            }
+void reprobe_command(Node& node, const std::string& args) {
+    std::string sub, rest;
+    split_cmd_args(args, sub, rest);
+
+    if (sub == "off") {
+        node.hb.reprobe_ms.store(0);
+    } else if (!sub.empty()) {
+        uint64_t ms = 0;
+        try { ms = std::stoull(sub); } catch (...) { ms = 0; }
+        if (ms == 0) {
+            std::cout << "Usage: reprobe [<ms> | off]\n";
+            return;
         }
+        node.hb.reprobe_ms.store(ms);
+    }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(refresh_ms));
+    size_t dead = 0, tombstones = 0;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        dead = node.schedule.dead_round().size();
+        tombstones = node.tombstones.size();
     }
 
-    set_nonblocking(false);
-    std::cout << "\nExited live view.\n";
+    const uint64_t every = node.hb.reprobe_ms.load();
+    if (every) std::cout << "Re-probe every " << every << " ms";
+    else std::cout << "Re-probe off";
+    std::cout << ": " << dead << " dead, " << tombstones << " tombstoned, "
+              << node.hb.reprobes_sent.load() << " sent\n";
 }
 
 CommandResult handle_command(const std::string& cmd, const std::string& args, Node& node) {
@@ -195,8 +579,10 @@ CommandResult handle_command(const std::string& cmd, const std::string& args, No
     if (cmd == "stop")   { node.stop(); return CommandResult::Continue; }
 
     if (cmd == "list") {
-        if (args == "live") {
-            live_list_members(node);
+        std::string sub, rest;
+        split_cmd_args(args, sub, rest);
+        if (sub == "live") {
+            live_view(node, rest);
         } else {
             list_members(node);
         }
@@ -208,6 +594,83 @@ CommandResult handle_command(const std::string& cmd, const std::string& args, No
         return CommandResult::Continue;
     }
 
+    if (cmd == "measure") {
+        measure_report(node);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "trace") {
+        trace_command(args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "log") {
+        log_command(args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "fault") {
+        fault_command(args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "queue") {
+        queue_command(node, args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "owner") {
+        owner_command(node, args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "nearest") {
+        nearest_command(node, args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "events") {
+        events_command(node, args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "zones") {
+        zones_command(node);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "discovery") {
+        discovery_command(node, args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "reprobe") {
+        reprobe_command(node, args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "broadcast") {
+        if (!node.running.load()) std::cout << "Node is not running.\n";
+        else if (!node.broadcasts.send(node, args))
+            std::cout << "Usage: broadcast <msg> (1-" << BCAST_MAX_BYTES << " bytes)\n";
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "broadcasts") {
+        broadcasts_command(node);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "meta") {
+        meta_command(node, args);
+        return CommandResult::Continue;
+    }
+
+    if (cmd == "tagged") {
+        tagged_command(node, args);
+        return CommandResult::Continue;
+    }
+
     if (cmd == "quit" || cmd == "exit") return CommandResult::Quit;
 
     std::cout << "Unknown command: " << cmd << "\n";
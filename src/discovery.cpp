@@ -0,0 +1,268 @@
+#include "discovery.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "join.h"
+#include "log.h"
+#include "membership.h"
+#include "membership_config.h"
+#include "net_util.h"
+#include "node.h"
+#include "piggyback.h"
+#include "sender.h"
+#include "string_util.h"
+#include "time_util.h"
+#include "trace.h"
+
+bool parse_discovery_addr(const std::string& s, DiscoveryConfig& out) {
+    DiscoveryConfig cfg;
+    const size_t colon = s.find(':');
+    cfg.group = s.substr(0, colon);
+
+    if (colon != std::string::npos) {
+        try {
+            const unsigned long p = std::stoul(s.substr(colon + 1));
+            if (p == 0 || p > 65535) return false;
+            cfg.port = (uint16_t)p;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    in_addr a{};
+    if (inet_pton(AF_INET, cfg.group.c_str(), &a) != 1 || !IN_MULTICAST(ntohl(a.s_addr))) return false;
+
+    out = cfg;
+    return true;
+}
+
+void Discovery::configure(const DiscoveryConfig& cfg) {
+    std::lock_guard<std::mutex> lk(mu_);
+    cfg_ = cfg;
+    enabled_ = true;
+}
+
+void Discovery::disable() {
+    std::lock_guard<std::mutex> lk(mu_);
+    enabled_ = false;
+}
+
+bool Discovery::enabled() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return enabled_;
+}
+
+DiscoveryConfig Discovery::config() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return cfg_;
+}
+
+DiscoveryStats Discovery::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+}
+
+// One socket for both directions: bound to the group port with address
+// reuse so several nodes on a host (or in tests) can share it, joined to
+// the group on the interface of node.ip, with loopback kept on.
+static int open_multicast(const DiscoveryConfig& cfg, const std::string& local_ip) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) { log_errno("discovery socket"); return -1; }
+
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg.port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        log_errno("discovery bind");
+        close(sock);
+        return -1;
+    }
+
+    in_addr iface{};
+    iface.s_addr = htonl(INADDR_ANY);
+    if (!local_ip.empty()) inet_pton(AF_INET, local_ip.c_str(), &iface);
+
+    ip_mreq mreq{};
+    inet_pton(AF_INET, cfg.group.c_str(), &mreq.imr_multiaddr);
+    mreq.imr_interface = iface;
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        log_errno("discovery join group");
+        close(sock);
+        return -1;
+    }
+
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+    unsigned char ttl = 1, loop = 1;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    timeval tv{};
+    tv.tv_usec = 100 * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return sock;
+}
+
+void Discovery::start(Node& node) {
+    if (th_.joinable() || !enabled()) return;
+
+    const DiscoveryConfig cfg = config();
+    const int sock = open_multicast(cfg, node.ip);
+    if (sock < 0) return;
+
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_ = {};
+    }
+    node_ = &node;
+    reply_window_ms_ = 0;
+    reply_count_ = 0;
+    stop_.store(false);
+    th_ = std::thread(&Discovery::loop, this, sock);
+    log_info("discovery: listening on %s:%u", cfg.group.c_str(), (unsigned)cfg.port);
+}
+
+void Discovery::stop() {
+    stop_.store(true);
+    if (th_.joinable()) th_.join();
+    node_ = nullptr;
+}
+
+void Discovery::announce(int sock) {
+    const DiscoveryConfig cfg = config();
+
+    sockaddr_in dst{};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(cfg.port);
+    inet_pton(AF_INET, cfg.group.c_str(), &dst.sin_addr);
+
+    const std::string msg = make_msg("DISCOVER", *node_);
+    if (sendto(sock, msg.data(), msg.size(), 0, (sockaddr*)&dst, sizeof(dst)) < 0) {
+        log_errno("discovery sendto");
+        return;
+    }
+    trace_packet(TraceKind::PacketOut, cfg.group, msg);
+
+    std::lock_guard<std::mutex> lk(mu_);
+    stats_.announces++;
+}
+
+void Discovery::handle(const std::string& msg, uint64_t now) {
+    const std::vector<std::string> f = split_ws(msg);
+    if (f.size() < 4 || f[0] != "DISCOVER") return;
+
+    const std::string& name = f[1];
+    const std::string& ip = f[2];
+    if (name == node_->name || !is_valid_ipv4(ip)) return;
+
+    trace_packet(TraceKind::PacketIn, ip, msg);
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_.received++;
+    }
+
+    // Only members can let someone in.
+    if (!node_->joined.load()) return;
+
+    uint64_t inc = 0;
+    try { inc = std::stoull(f[3]); } catch (...) { return; }
+
+    size_t alive = 0;
+    {
+        std::lock_guard<std::mutex> lk(node_->membership_mu);
+        auto it = node_->membership.find(name);
+        if (it != node_->membership.end() && it->second.status == MemberStatus::Alive &&
+            it->second.incarnation >= inc)
+            return;   // already a member; its announce is for others
+
+        for (const auto& [n, info] : node_->membership)
+            if (info.status == MemberStatus::Alive) alive++;
+    }
+
+    // About DISCOVERY_RESPONDERS members answer, whatever the cluster size.
+    std::uniform_int_distribution<size_t> pick(0, std::max<size_t>(alive, 1) - 1);
+    if (pick(rng_) >= DISCOVERY_RESPONDERS) return;
+
+    if (now - reply_window_ms_ >= 1000) {
+        reply_window_ms_ = now;
+        reply_count_ = 0;
+    }
+    if (reply_count_ >= DISCOVERY_REPLY_RATE) {
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_.rate_limited++;
+        return;
+    }
+    reply_count_++;
+
+    {
+        std::lock_guard<std::mutex> lk(node_->membership_mu);
+        merge_member(*node_, name, ip, f[3], MemberStatus::Alive, now, true);
+    }
+
+    send_udp(ip, make_msg("WELCOME", *node_, build_piggy_data(*node_, name, PIGGY_K)));
+
+    std::lock_guard<std::mutex> lk(mu_);
+    stats_.replies++;
+}
+
+void Discovery::loop(int sock) {
+    trace_set_thread_name("discovery");
+
+    const uint64_t started = now_ms();
+    uint64_t next_announce = started;
+    unsigned attempt = 0;
+
+    while (!stop_.load() && node_->running.load()) {
+        const uint64_t now = now_ms();
+
+        if (!node_->joined.load()) {
+            if (now >= next_announce) {
+                announce(sock);
+                next_announce = now + join_backoff_ms(attempt++, rng_);
+            }
+
+            if (now - started >= DISCOVERY_SOLO_MS) {
+                // Nobody answered: seeds and group are empty or down.
+                node_->attempt_join.store(false);
+                node_->joined.store(true);
+                {
+                    std::lock_guard<std::mutex> lk(mu_);
+                    stats_.bootstrapped = true;
+                }
+                log_info("discovery: no members found, starting a new cluster");
+            }
+        } else if (now >= next_announce) {
+            // Each member announces with probability 1/alive per period,
+            // about one announce per period for the whole cluster.
+            size_t alive = 0;
+            {
+                std::lock_guard<std::mutex> lk(node_->membership_mu);
+                for (const auto& [n, info] : node_->membership)
+                    if (info.status == MemberStatus::Alive) alive++;
+            }
+            std::uniform_int_distribution<size_t> pick(0, std::max<size_t>(alive, 1) - 1);
+            if (pick(rng_) == 0) announce(sock);
+            next_announce = now + DISCOVERY_ANNOUNCE_MS;
+            attempt = 0;
+        }
+
+        char buf[512];
+        const ssize_t n = recv(sock, buf, sizeof(buf), 0);
+        if (n > 0) handle(std::string(buf, (size_t)n), now_ms());
+    }
+
+    close(sock);
+}
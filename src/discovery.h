@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+class Node;
+
+inline const char* const DISCOVERY_PATH  = "discovery.conf";
+inline const char* const DISCOVERY_GROUP = "239.255.71.1";
+inline constexpr uint16_t DISCOVERY_PORT = 9001;
+
+struct DiscoveryConfig {
+    std::string group = DISCOVERY_GROUP;
+    uint16_t port = DISCOVERY_PORT;
+};
+
+// Parses "<group>[:<port>]"; the group must be an IPv4 multicast address.
+bool parse_discovery_addr(const std::string& s, DiscoveryConfig& out);
+
+struct DiscoveryStats {
+    uint64_t announces = 0;
+    uint64_t received = 0;
+    uint64_t replies = 0;
+    uint64_t rate_limited = 0;
+    bool bootstrapped = false;   // started a new cluster alone
+};
+
+// Seedless join over IP multicast. A node that is not joined sends
+// `DISCOVER <name> <ip> <inc>` to the group; members that do not know it
+// answer with a unicast WELCOME, so the join takes one round trip through
+// whichever members answer rather than the seeds. Runs next to the seed
+// join loop, never instead of it.
+class Discovery {
+public:
+    void configure(const DiscoveryConfig& cfg);
+    void disable();
+    bool enabled() const;
+    DiscoveryConfig config() const;
+
+    void start(Node& node);
+    void stop();
+    bool running() const { return th_.joinable(); }
+
+    DiscoveryStats stats() const;
+
+private:
+    void loop(int sock);
+    void announce(int sock);
+    void handle(const std::string& msg, uint64_t now);
+
+    mutable std::mutex mu_;       // config and stats
+    bool enabled_ = false;
+    DiscoveryConfig cfg_;
+    DiscoveryStats stats_;
+
+    Node* node_ = nullptr;
+    std::thread th_;
+    std::atomic<bool> stop_{false};
+
+    std::mt19937 rng_{std::random_device{}()};
+    uint64_t reply_window_ms_ = 0;
+    uint64_t reply_count_ = 0;
+};
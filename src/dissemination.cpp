@@ -0,0 +1,139 @@
+#include "dissemination.h"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+
+#include "membership.h"
+#include "membership_config.h"
+#include "node.h"
+#include "piggyback.h"
+#include "sender.h"
+#include "zones.h"
+
+void Dissemination::enqueue(const std::string& name) {
+    auto [it, inserted] = sent_.try_emplace(name, 0);
+    if (!inserted) {
+        order_.erase({ it->second, name });
+        it->second = 0;
+    }
+    order_.insert({ 0, name });
+}
+
+void Dissemination::erase(const std::string& name) {
+    auto it = sent_.find(name);
+    if (it == sent_.end()) return;
+    order_.erase({ it->second, name });
+    sent_.erase(it);
+}
+
+std::vector<std::string> Dissemination::take(size_t k, size_t limit, const std::string& exclude) {
+    std::vector<std::string> out;
+    for (auto it = order_.begin(); out.size() < k && it != order_.end(); ) {
+        if (it->second == exclude) {
+            ++it;
+            continue;
+        }
+        out.push_back(it->second);
+        it = order_.erase(it);
+    }
+
+    for (const auto& name : out) {
+        uint32_t& count = sent_[name];
+        if (++count >= limit) sent_.erase(name);
+        else order_.insert({ count, name });
+    }
+    return out;
+}
+
+void Dissemination::request_push(const std::string& name) {
+    pushes_.push_back(name);
+    has_pushes_.store(true, std::memory_order_relaxed);
+}
+
+std::vector<std::string> Dissemination::take_pushes() {
+    std::vector<std::string> out;
+    out.swap(pushes_);
+    has_pushes_.store(false, std::memory_order_relaxed);
+    return out;
+}
+
+void Dissemination::clear() {
+    sent_.clear();
+    order_.clear();
+    pushes_.clear();
+    has_pushes_.store(false, std::memory_order_relaxed);
+}
+
+size_t retransmit_limit(size_t members) {
+    size_t log2n = 0;
+    while (((size_t)1 << log2n) < members + 1) log2n++;
+    return DISSEMINATE_MULT * std::max<size_t>(log2n, 1);
+}
+
+static const char* push_type(MemberStatus st) {
+    switch (st) {
+        case MemberStatus::Suspect: return "SUSPECT";
+        case MemberStatus::Dead:    return "CONFIRM";
+        case MemberStatus::Left:    return "LEAVE";
+        default:                    return "ALIVE";
+    }
+}
+
+void push_updates(Node& node) {
+    if (!node.dissemination.has_pushes()) return;
+
+    static thread_local std::mt19937 rng(std::random_device{}());
+
+    // One full and one compact message per subject; each target gets the
+    // form it understands.
+    std::vector<std::pair<std::string, std::string>> msgs;
+    std::vector<std::vector<std::pair<std::string, bool>>> targets;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+
+        // Pushes stay in our zone; representatives also tell the first
+        // representative of each other zone.
+        const ZoneReps reps = node.schedule.representatives();
+        const std::string& my_zone = node.schedule.zone();
+        const bool rep = node.schedule.is_representative();
+
+        for (const auto& subject : node.dissemination.take_pushes()) {
+            auto it = node.membership.find(subject);
+            if (it == node.membership.end() || it->second.ip.empty()) continue;
+
+            // FANOUT alive members of our zone other than us and the
+            // subject, from a sample with room to skip suspects.
+            std::vector<std::string> sample;
+            node.schedule.local().sample(2 * FANOUT, rng, sample);
+
+            std::vector<std::pair<std::string, bool>> picked;
+            for (const auto& name : sample) {
+                if (picked.size() == FANOUT) break;
+                if (name == subject) continue;
+                auto m = node.membership.find(name);
+                if (m == node.membership.end() || m->second.status != MemberStatus::Alive) continue;
+                picked.emplace_back(m->second.ip, speaks_ids(m->second));
+            }
+
+            if (rep) {
+                for (const auto& [zone, names] : reps) {
+                    if (zone == my_zone) continue;
+                    auto r = node.membership.find(names.front());
+                    if (names.front() == subject || r->second.ip.empty()) continue;
+                    picked.emplace_back(r->second.ip, speaks_ids(r->second));
+                }
+            }
+
+            const char* type = push_type(it->second.status);
+            const std::string& id = node.ids.id_of(subject);
+            msgs.emplace_back(make_msg(type, node, make_entry(subject, it->second)),
+                              make_msg(type, node, make_entry(subject, it->second, id), true));
+            targets.push_back(std::move(picked));
+        }
+    }
+
+    for (size_t i = 0; i < msgs.size(); i++)
+        for (const auto& [ip, compact] : targets[i])
+            send_udp(ip, compact ? msgs[i].second : msgs[i].first);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Node;
+
+// Members whose entry changed recently, retransmitted ahead of random
+// entries in piggybacks until each has gone out retransmit_limit() times
+// (SWIM's infection-style dissemination). Local detections and refutations
+// are also pushed at once to FANOUT members as SUSPECT / CONFIRM / ALIVE.
+// Guarded by Node::membership_mu, except has_pushes().
+class Dissemination {
+public:
+    // (Re)starts retransmission of `name`'s current entry.
+    void enqueue(const std::string& name);
+    void erase(const std::string& name);
+
+    // Up to k names sent the fewest times; each counts as sent once more and
+    // is dropped after `limit` sends. `exclude` (the recipient) is skipped
+    // and not counted.
+    std::vector<std::string> take(size_t k, size_t limit, const std::string& exclude = "");
+
+    void request_push(const std::string& name);
+    std::vector<std::string> take_pushes();
+    bool has_pushes() const { return has_pushes_.load(std::memory_order_relaxed); }
+
+    size_t size() const { return sent_.size(); }
+    void clear();
+
+private:
+    std::unordered_map<std::string, uint32_t> sent_;
+    std::set<std::pair<uint32_t, std::string>> order_;
+
+    std::vector<std::string> pushes_;
+    std::atomic<bool> has_pushes_{false};
+};
+
+// DISSEMINATE_MULT * ceil(log2(members + 1)).
+size_t retransmit_limit(size_t members);
+
+// Sends every requested push to FANOUT random alive members. Takes
+// membership_mu; call without it.
+void push_updates(Node& node);
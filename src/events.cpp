@@ -0,0 +1,274 @@
+#include "events.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <ostream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "sender.h"
+#include "time_util.h"
+#include "trace.h"
+
+const char* member_event_name(MemberEventKind k) {
+    switch (k) {
+        case MemberEventKind::Joined:  return "joined";
+        case MemberEventKind::Suspect: return "suspect";
+        case MemberEventKind::Dead:    return "dead";
+        case MemberEventKind::Left:    return "left";
+        case MemberEventKind::Alive:   return "alive";
+        case MemberEventKind::Removed: return "removed";
+        case MemberEventKind::Meta:    return "meta";
+        default:                       return "?";
+    }
+}
+
+std::string format_event(const MemberEvent& e) {
+    std::string out = std::to_string(e.seq);
+    out.push_back(' ');
+    out += member_event_name(e.kind);
+    out.push_back(' ');
+    out += e.name;
+    out.push_back(' ');
+    out += e.ip.empty() ? "-" : e.ip;
+    out.push_back(' ');
+    out += std::to_string(e.incarnation);
+    out.push_back(' ');
+    out.push_back(e.status);
+    out.push_back(' ');
+    out += std::to_string(e.wall_ms);
+    return out;
+}
+
+bool stream_events(const std::string& ip, uint64_t since, std::ostream& out) {
+    int sock = connect_tcp(ip, 2000);
+    if (sock < 0) return false;
+
+    const std::string req = "SUBSCRIBE " + std::to_string(since) + "\n";
+    if (!send_all(sock, req.data(), req.size())) {
+        close(sock);
+        return false;
+    }
+
+    // Events can be minutes apart; wait indefinitely.
+    timeval tv{};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    char buffer[4096];
+    while (true) {
+        const ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        out.write(buffer, n);
+        out.flush();
+    }
+
+    close(sock);
+    return true;
+}
+
+void EventBus::start() {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (running_) return;
+    running_ = true;
+    th_ = std::thread(&EventBus::loop, this);
+}
+
+void EventBus::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (th_.joinable()) th_.join();
+
+    std::lock_guard<std::mutex> lk(streams_mu_);
+    for (auto& s : streams_) close(s.fd);
+    streams_.clear();
+}
+
+void EventBus::publish(MemberEventKind kind, const std::string& name, const std::string& ip,
+                       uint64_t incarnation, char status) {
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!running_) return;
+
+        MemberEvent e;
+        e.seq = next_seq_++;
+        e.kind = kind;
+        e.name = name;
+        e.ip = ip;
+        e.incarnation = incarnation;
+        e.status = status;
+        e.wall_ms = wall_ms();
+        pending_.push_back(std::move(e));
+        wake = pending_.size() == 1;
+    }
+    if (wake) cv_.notify_one();
+}
+
+uint64_t EventBus::subscribe(EventHandler h) {
+    std::lock_guard<std::mutex> lk(subs_mu_);
+    const uint64_t id = next_sub_++;
+    subs_.emplace_back(id, std::make_shared<EventHandler>(std::move(h)));
+    return id;
+}
+
+void EventBus::unsubscribe(uint64_t id) {
+    std::lock_guard<std::mutex> lk(subs_mu_);
+    for (auto it = subs_.begin(); it != subs_.end(); ++it) {
+        if (it->first == id) { subs_.erase(it); return; }
+    }
+}
+
+std::vector<MemberEvent> EventBus::recent(size_t n) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    const size_t k = std::min(n, history_.size());
+    return std::vector<MemberEvent>(history_.end() - (std::ptrdiff_t)k, history_.end());
+}
+
+uint64_t EventBus::last_seq() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return next_seq_ - 1;
+}
+
+void EventBus::attach_stream(int fd, uint64_t since) {
+    Stream s;
+    s.fd = fd;
+
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        // First sequence number the dispatcher has not handed out yet.
+        const uint64_t end = next_seq_ - pending_.size();
+        s.next_seq = end;
+
+        if (since != 0 && since < end) {
+            const uint64_t oldest = history_.empty() ? end : history_.front().seq;
+            if (since < oldest) {
+                s.out += "GAP " + std::to_string(oldest) + "\n";
+                since = oldest;
+            }
+            s.next_seq = since;
+        }
+        s.out = "SUBSCRIBED " + std::to_string(s.next_seq) + "\n" + s.out;
+
+        for (const auto& e : history_) {
+            if (e.seq < s.next_seq) continue;
+            s.out += format_event(e);
+            s.out.push_back('\n');
+        }
+        if (!history_.empty() && history_.back().seq >= s.next_seq)
+            s.next_seq = history_.back().seq + 1;
+    }
+
+    std::lock_guard<std::mutex> lk(streams_mu_);
+    if (!flush(s)) {
+        close(fd);
+        return;
+    }
+    streams_.push_back(std::move(s));
+}
+
+bool EventBus::flush(Stream& s) {
+    while (!s.out.empty()) {
+        const ssize_t n = send(s.fd, s.out.data(), s.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n > 0) {
+            s.out.erase(0, (size_t)n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false;
+    }
+    return s.out.size() <= EVENTS_TCP_BACKLOG;
+}
+
+void EventBus::deliver_streams(const std::vector<MemberEvent>& batch) {
+    std::lock_guard<std::mutex> lk(streams_mu_);
+    for (auto it = streams_.begin(); it != streams_.end(); ) {
+        for (const auto& e : batch) {
+            if (e.seq < it->next_seq) continue;
+            it->out += format_event(e);
+            it->out.push_back('\n');
+            it->next_seq = e.seq + 1;
+        }
+
+        if (flush(*it)) {
+            ++it;
+        } else {
+            close(it->fd);
+            it = streams_.erase(it);
+        }
+    }
+}
+
+// Between batches: sends what a full socket buffer held back and closes
+// streams whose client went away, instead of waiting for the next event.
+void EventBus::tend_streams() {
+    std::lock_guard<std::mutex> lk(streams_mu_);
+    if (streams_.empty()) return;
+
+    std::vector<pollfd> fds;
+    fds.reserve(streams_.size());
+    for (const auto& s : streams_)
+        fds.push_back({ s.fd, (short)(POLLRDHUP | (s.out.empty() ? 0 : POLLOUT)), 0 });
+    if (poll(fds.data(), fds.size(), 0) <= 0) return;
+
+    size_t i = 0;
+    for (auto it = streams_.begin(); it != streams_.end(); i++) {
+        const short re = fds[i].revents;
+        bool ok = !(re & (POLLHUP | POLLERR | POLLNVAL | POLLRDHUP));
+        if (ok && (re & POLLOUT)) ok = flush(*it);
+
+        if (ok) {
+            ++it;
+        } else {
+            close(it->fd);
+            it = streams_.erase(it);
+        }
+    }
+}
+
+void EventBus::loop() {
+    trace_set_thread_name("events");
+
+    std::unique_lock<std::mutex> lk(mu_);
+    while (running_) {
+        cv_.wait_for(lk, std::chrono::milliseconds(EVENTS_TEND_MS),
+                     [&]{ return !running_ || !pending_.empty(); });
+        if (!running_) break;
+
+        if (!pending_.empty()) {
+            // Let a burst (a partition healing, a rack dying) become one batch.
+            cv_.wait_for(lk, std::chrono::milliseconds(EVENTS_BATCH_MS), [&]{ return !running_; });
+
+            std::vector<MemberEvent> batch;
+            batch.swap(pending_);
+            for (const auto& e : batch) {
+                history_.push_back(e);
+                if (history_.size() > EVENTS_HISTORY) history_.pop_front();
+            }
+            lk.unlock();
+
+            std::vector<std::shared_ptr<EventHandler>> handlers;
+            {
+                std::lock_guard<std::mutex> slk(subs_mu_);
+                for (const auto& [id, h] : subs_) handlers.push_back(h);
+            }
+            for (const auto& h : handlers) (*h)(batch);
+
+            deliver_streams(batch);
+        } else {
+            lk.unlock();
+        }
+
+        tend_streams();
+        lk.lock();
+    }
+}
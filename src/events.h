@@ -0,0 +1,114 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Membership change events. Node::on_member_change and merge_meta publish
+// into a pending list under membership_mu (an append, nothing else); a
+// dispatcher thread hands them out in batches of up to EVENTS_BATCH_MS, so
+// subscribers never run on the packet path or under membership_mu.
+//
+// Every event carries a sequence number, increasing by one per event for
+// the life of the process. The last EVENTS_HISTORY events are kept so a
+// consumer can resume from the sequence number it last saw.
+//
+// External consumers send `SUBSCRIBE [seq]` on the TCP port: the stream
+// starts with `SUBSCRIBED <first seq>`, then `GAP <oldest seq>` if `seq` is
+// older than the history, then one line per event from `seq` on (or only
+// new events without it):
+//
+//   <seq> <kind> <name> <ip> <incarnation> <status> <wall ms>
+
+inline constexpr uint64_t EVENTS_BATCH_MS    = 50;
+inline constexpr size_t   EVENTS_HISTORY     = 4096;
+inline constexpr size_t   EVENTS_TCP_BACKLOG = 256 * 1024;   // unsent bytes before a stream is cut
+inline constexpr uint64_t EVENTS_TEND_MS     = 250;          // retry backlogs, notice hang-ups
+
+enum class MemberEventKind {
+    Joined,     // first time in our view
+    Suspect,
+    Dead,
+    Left,       // announced its departure
+    Alive,      // back from Suspect or Dead
+    Removed,    // reclaimed after DEAD_RETAIN_MS
+    Meta        // metadata changed
+};
+
+const char* member_event_name(MemberEventKind k);
+
+struct MemberEvent {
+    uint64_t seq = 0;
+    MemberEventKind kind = MemberEventKind::Joined;
+    std::string name;
+    std::string ip;
+    uint64_t incarnation = 0;
+    char status = 'A';
+    uint64_t wall_ms = 0;
+};
+
+std::string format_event(const MemberEvent& e);
+
+// Client side of SUBSCRIBE: copies the stream from the node at `ip` to `out`
+// until the node closes it. Returns false if it could not connect.
+bool stream_events(const std::string& ip, uint64_t since, std::ostream& out);
+
+using EventHandler = std::function<void(const std::vector<MemberEvent>&)>;
+
+class EventBus {
+public:
+    void start();
+    void stop();
+
+    // Cheap; safe under membership_mu.
+    void publish(MemberEventKind kind, const std::string& name, const std::string& ip,
+                 uint64_t incarnation, char status);
+
+    // Handlers run on the dispatcher thread, one call per batch. Kept across
+    // stop/start.
+    uint64_t subscribe(EventHandler h);
+    void unsubscribe(uint64_t id);
+
+    // Streams events from `since` (0: only new ones) to a TCP client; the
+    // bus owns `fd` from here on.
+    void attach_stream(int fd, uint64_t since);
+
+    // Up to n most recent events.
+    std::vector<MemberEvent> recent(size_t n) const;
+    uint64_t last_seq() const;
+
+private:
+    struct Stream {
+        int fd = -1;
+        uint64_t next_seq = 0;
+        std::string out;
+    };
+
+    void loop();
+    static bool flush(Stream& s);
+    void deliver_streams(const std::vector<MemberEvent>& batch);
+    void tend_streams();
+
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::thread th_;
+    uint64_t next_seq_ = 1;
+    std::vector<MemberEvent> pending_;
+    std::deque<MemberEvent> history_;
+
+    std::mutex subs_mu_;
+    uint64_t next_sub_ = 1;
+    std::vector<std::pair<uint64_t, std::shared_ptr<EventHandler>>> subs_;
+
+    std::mutex streams_mu_;
+    std::vector<Stream> streams_;
+};
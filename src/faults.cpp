@@ -0,0 +1,236 @@
+#include "faults.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "string_util.h"
+#include "time_util.h"
+#include "trace.h"
+
+static constexpr uint64_t FAULT_DEFAULT_SEED = 1;
+
+namespace {
+
+struct Delayed {
+    uint64_t due_ms;
+    uint64_t seq;
+    std::function<void()> deliver;
+};
+
+struct Later {
+    bool operator()(const Delayed& a, const Delayed& b) const {
+        return a.due_ms != b.due_ms ? a.due_ms > b.due_ms : a.seq > b.seq;
+    }
+};
+
+struct FaultState {
+    ~FaultState() {
+        {
+            std::lock_guard<std::mutex> lk(q_mu);
+            stopping = true;
+        }
+        q_cv.notify_all();
+        if (th.joinable()) th.join();
+    }
+
+    std::atomic<bool> any{false};
+
+    std::mutex mu;   // rules, stats, rng
+    std::unordered_map<std::string, FaultRule> rules[2];
+    FaultStats stats[2];
+    std::mt19937_64 rng{FAULT_DEFAULT_SEED};
+
+    // Delayed datagrams, delivered in due order by one thread started on
+    // first use.
+    std::mutex q_mu;
+    std::condition_variable q_cv;
+    std::priority_queue<Delayed, std::vector<Delayed>, Later> q;
+    uint64_t q_seq = 0;
+    bool stopping = false;
+    std::thread th;
+};
+
+FaultState g_faults;
+
+}
+
+bool parse_fault_rule(const std::string& s, FaultRule& out) {
+    FaultRule r;
+    for (const auto& tok : split_ws(s)) {
+        if (tok == "block") { r.block = true; continue; }
+
+        const size_t eq = tok.find('=');
+        if (eq == std::string::npos) return false;
+        const std::string key = tok.substr(0, eq);
+        const std::string val = tok.substr(eq + 1);
+
+        try {
+            if (key == "drop" || key == "dup" || key == "reorder") {
+                const double p = std::stod(val);
+                if (p < 0 || p > 1) return false;
+                (key == "drop" ? r.drop : key == "dup" ? r.dup : r.reorder) = p;
+            } else if (key == "delay") {
+                r.delay_ms = std::stoull(val);
+            } else if (key == "jitter") {
+                r.jitter_ms = std::stoull(val);
+            } else {
+                return false;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    out = r;
+    return true;
+}
+
+std::string fault_rule_str(const FaultRule& r) {
+    if (r.block) return "block";
+
+    std::ostringstream out;
+    if (r.drop > 0) out << "drop=" << r.drop << " ";
+    if (r.delay_ms) out << "delay=" << r.delay_ms << " ";
+    if (r.jitter_ms) out << "jitter=" << r.jitter_ms << " ";
+    if (r.dup > 0) out << "dup=" << r.dup << " ";
+    if (r.reorder > 0) out << "reorder=" << r.reorder << " ";
+    const std::string s = out.str();
+    return s.empty() ? "pass" : s.substr(0, s.size() - 1);
+}
+
+static void update_any_locked() {
+    g_faults.any.store(!g_faults.rules[0].empty() || !g_faults.rules[1].empty(), std::memory_order_relaxed);
+}
+
+void fault_set(FaultDir dir, const std::string& peer, const FaultRule& rule) {
+    std::lock_guard<std::mutex> lk(g_faults.mu);
+    g_faults.rules[(size_t)dir][peer] = rule;
+    update_any_locked();
+}
+
+bool fault_clear(FaultDir dir, const std::string& peer) {
+    std::lock_guard<std::mutex> lk(g_faults.mu);
+    const bool erased = g_faults.rules[(size_t)dir].erase(peer) > 0;
+    update_any_locked();
+    return erased;
+}
+
+void fault_clear_all() {
+    std::lock_guard<std::mutex> lk(g_faults.mu);
+    g_faults.rules[0].clear();
+    g_faults.rules[1].clear();
+    g_faults.stats[0] = {};
+    g_faults.stats[1] = {};
+    update_any_locked();
+}
+
+void fault_seed(uint64_t seed) {
+    std::lock_guard<std::mutex> lk(g_faults.mu);
+    g_faults.rng.seed(seed);
+}
+
+std::vector<FaultEntry> fault_rules() {
+    std::lock_guard<std::mutex> lk(g_faults.mu);
+    std::vector<FaultEntry> out;
+    for (FaultDir dir : { FaultDir::Out, FaultDir::In })
+        for (const auto& [peer, rule] : g_faults.rules[(size_t)dir]) out.push_back({ dir, peer, rule });
+    return out;
+}
+
+FaultStats fault_stats(FaultDir dir) {
+    std::lock_guard<std::mutex> lk(g_faults.mu);
+    return g_faults.stats[(size_t)dir];
+}
+
+bool faults_enabled() {
+    return g_faults.any.load(std::memory_order_relaxed);
+}
+
+static void fault_loop() {
+    trace_set_thread_name("faults");
+
+    std::unique_lock<std::mutex> lk(g_faults.q_mu);
+    while (!g_faults.stopping) {
+        if (g_faults.q.empty()) {
+            g_faults.q_cv.wait(lk);
+            continue;
+        }
+
+        const uint64_t now = now_ms();
+        const uint64_t due = g_faults.q.top().due_ms;
+        if (due > now) {
+            g_faults.q_cv.wait_for(lk, std::chrono::milliseconds(due - now));
+            continue;
+        }
+
+        std::function<void()> deliver = std::move(const_cast<Delayed&>(g_faults.q.top()).deliver);
+        g_faults.q.pop();
+        lk.unlock();
+        deliver();
+        lk.lock();
+    }
+}
+
+static void schedule(uint64_t due_ms, std::function<void()> deliver) {
+    {
+        std::lock_guard<std::mutex> lk(g_faults.q_mu);
+        if (!g_faults.th.joinable()) g_faults.th = std::thread(fault_loop);
+        g_faults.q.push({ due_ms, g_faults.q_seq++, std::move(deliver) });
+    }
+    g_faults.q_cv.notify_one();
+}
+
+bool fault_apply(FaultDir dir, const std::string& peer, std::function<void()> deliver) {
+    if (!faults_enabled()) return false;
+
+    uint64_t delays[2] = { 0, 0 };
+    size_t copies = 1;
+    {
+        std::lock_guard<std::mutex> lk(g_faults.mu);
+        const auto& rules = g_faults.rules[(size_t)dir];
+        auto it = rules.find(peer);
+        if (it == rules.end()) it = rules.find("*");
+        if (it == rules.end()) return false;
+
+        const FaultRule& r = it->second;
+        FaultStats& st = g_faults.stats[(size_t)dir];
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+        if (r.block) { st.blocked++; return true; }
+        if (r.drop > 0 && coin(g_faults.rng) < r.drop) { st.dropped++; return true; }
+
+        if (r.dup > 0 && coin(g_faults.rng) < r.dup) {
+            copies = 2;
+            st.duplicated++;
+        }
+        for (size_t i = 0; i < copies; i++) {
+            delays[i] = r.delay_ms;
+            if (r.jitter_ms)
+                delays[i] += std::uniform_int_distribution<uint64_t>(0, r.jitter_ms)(g_faults.rng);
+            if (r.reorder > 0 && coin(g_faults.rng) < r.reorder) {
+                delays[i] += FAULT_REORDER_MS;
+                st.reordered++;
+            }
+        }
+        if (delays[0] || (copies == 2 && delays[1])) st.delayed++;
+        st.passed++;
+    }
+
+    const uint64_t now = now_ms();
+    for (size_t i = 0; i < copies; i++) {
+        if (delays[i] == 0) deliver();
+        else if (i + 1 == copies) schedule(now + delays[i], std::move(deliver));
+        else schedule(now + delays[i], deliver);
+    }
+    return true;
+}
+
+void fault_drop_pending() {
+    std::lock_guard<std::mutex> lk(g_faults.q_mu);
+    while (!g_faults.q.empty()) g_faults.q.pop();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Fault injection around send_udp() and the UDP receiver, for measuring
+// detection under loss and delay without tc/netem or root. Rules apply per
+// peer IPv4 (or "*" for every peer without its own rule) and per
+// direction; a one-way partition is a rule with `block` in one direction.
+// Decisions come from one seeded generator, so a run with the same seed
+// and traffic makes the same choices.
+//
+// With no rules installed the layer costs one relaxed atomic load.
+
+enum class FaultDir : uint8_t { Out, In };
+
+struct FaultRule {
+    double drop = 0;           // probability a datagram is lost
+    uint64_t delay_ms = 0;     // added to every datagram
+    uint64_t jitter_ms = 0;    // plus uniform [0, jitter_ms]
+    double dup = 0;            // probability of a second copy
+    double reorder = 0;        // probability of being held back FAULT_REORDER_MS
+    bool block = false;        // drop everything (partition)
+};
+
+inline constexpr uint64_t FAULT_REORDER_MS = 50;
+
+struct FaultStats {
+    uint64_t passed = 0;
+    uint64_t dropped = 0;
+    uint64_t blocked = 0;
+    uint64_t delayed = 0;
+    uint64_t duplicated = 0;
+    uint64_t reordered = 0;
+};
+
+// Parses "drop=0.1 delay=20 jitter=5 dup=0.01 reorder=0.05 block"; false
+// on an unknown or out-of-range setting.
+bool parse_fault_rule(const std::string& s, FaultRule& out);
+std::string fault_rule_str(const FaultRule& r);
+
+void fault_set(FaultDir dir, const std::string& peer, const FaultRule& rule);
+bool fault_clear(FaultDir dir, const std::string& peer);
+void fault_clear_all();
+void fault_seed(uint64_t seed);
+
+struct FaultEntry {
+    FaultDir dir;
+    std::string peer;
+    FaultRule rule;
+};
+std::vector<FaultEntry> fault_rules();
+FaultStats fault_stats(FaultDir dir);
+
+// Whether any rule is installed; lets callers skip building the callback.
+bool faults_enabled();
+
+// Runs `deliver` for a datagram to/from `peer` zero, one or two times, now
+// or later from the fault thread, as the matching rule says. Returns false
+// when no rule matches, and the caller delivers it itself.
+bool fault_apply(FaultDir dir, const std::string& peer, std::function<void()> deliver);
+
+// Forgets delayed datagrams; called when the node stops.
+void fault_drop_pending();
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+inline uint64_t fnv1a64(const char* p, size_t n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+inline uint64_t fnv1a64(const std::string& s) {
+    return fnv1a64(s.data(), s.size());
+}
+
+// splitmix64 finalizer; spreads small differences over all bits.
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline std::string to_hex(uint64_t v) {
+    char buf[16];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v, 16);
+    return std::string(buf, r.ptr);
+}
+
+inline bool parse_hex(const std::string& s, uint64_t& out) {
+    if (s.empty()) return false;
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out, 16);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
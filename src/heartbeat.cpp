@@ -7,52 +7,16 @@
 #include <mutex>
 #include <algorithm>
 
+#include <arpa/inet.h>
+
+#include "membership.h"
 #include "node.h"
+#include "piggyback.h"
 #include "sender.h"
 #include "time_util.h"
+#include "trace.h"
 #include "membership_config.h"
 
-static std::string build_piggy_data(Node& node,
-                                    const std::string& exclude_name,
-                                    size_t k) {
-    std::vector<std::string> entries;
-    entries.reserve(node.membership.size());
-
-    for (const auto& [n, info] : node.membership) {
-        if (n.empty() || info.ip.empty()) continue;
-        if (n == node.name) continue;
-        if (n == exclude_name) continue;
-
-        std::string e;
-        e.reserve(n.size() + info.ip.size() + 40);
-        e += n;
-        e.push_back('@');
-        e += info.ip;
-        e.push_back('@');
-        e += std::to_string(info.incarnation);
-        e.push_back('@');
-        e.push_back(info.status == MemberStatus::Alive ? 'A' :
-                    info.status == MemberStatus::Suspect ? 'S' : 'D');
-        e.push_back('@');
-        e += std::to_string(info.last_seen_ms);
-
-        entries.push_back(std::move(e));
-    }
-
-    if (entries.empty() || k == 0) return "";
-
-    static thread_local std::mt19937 rng(std::random_device{}());
-    std::shuffle(entries.begin(), entries.end(), rng);
-    if (entries.size() > k) entries.resize(k);
-
-    std::string csv;
-    for (size_t i = 0; i < entries.size(); i++) {
-        if (i) csv.push_back(',');
-        csv += entries[i];
-    }
-    return csv;
-}
-
 void Heartbeat::start(Node& node) {
     if (th_.joinable()) return;
     node_ = &node;
@@ -64,191 +28,290 @@ void Heartbeat::stop() {
     node_ = nullptr;
 }
 
-void Heartbeat::clear_probe(const std::string& target) {
+uint64_t Heartbeat::clear_probe(const std::string& target) {
     std::lock_guard<std::mutex> lk(probes_mu_);
-    probes_.erase(target);
+    auto it = probes_.find(target);
+    if (it == probes_.end()) return 0;
+
+    const uint64_t rtt_us = it->second.phase == Phase::Direct ? now_us() - it->second.sent_us : 0;
+    probes_.erase(it);
+    return rtt_us;
 }
 
-void Heartbeat::loop() {
-    using namespace std::chrono;
+std::string Heartbeat::probe_target_at(const std::string& ip) {
+    std::lock_guard<std::mutex> lk(probes_mu_);
+    for (const auto& [target, p] : probes_)
+        if (p.ip == ip) return target;
+    return "";
+}
 
-    while (node_ && node_->running.load()) {
+// Orders PING-REQ helpers by estimated RTT to the target, so the indirect
+// probe travels a short path. Helpers without a coordinate keep their
+// sampled order after the ranked ones. Caller must hold membership_mu.
+void Heartbeat::rank_by_proximity(std::vector<std::string>& helpers, const std::string& target) {
+    constexpr double unknown = 1e300;
+    std::vector<std::pair<double, std::string>> ranked;
+    ranked.reserve(helpers.size());
+
+    auto t = node_->membership.find(target);
+    const MemberInfo* tinfo = (t != node_->membership.end() && t->second.has_coord) ? &t->second : nullptr;
+
+    for (auto& h : helpers) {
+        double d = unknown;
+        auto it = node_->membership.find(h);
+        if (tinfo && it != node_->membership.end() && it->second.has_coord)
+            d = coord_distance(tinfo->coord, it->second.coord);
+        ranked.emplace_back(d, std::move(h));
+    }
 
-        const uint64_t now = now_ms();
-        
-        // timeouts
-        std::vector<std::string> escalate_to_indirect;
-        std::vector<std::string> escalate_to_suspect;
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 0; i < ranked.size(); i++) helpers[i] = std::move(ranked[i].second);
+}
 
-        {
-            std::lock_guard<std::mutex> lk(probes_mu_);
+void Heartbeat::probe(const std::string& target, uint64_t now) {
+    {
+        std::lock_guard<std::mutex> lk(probes_mu_);
+        if (probes_.count(target)) return;
+    }
 
-            for (auto it = probes_.begin(); it != probes_.end(); ) {
+    std::string target_ip;
+    bool compact = false;
 
-                if (now < it->second.deadline_ms) {
-                    ++it;
-                    continue;
-                }
-
-                if (it->second.phase == Phase::Direct) {
-                    escalate_to_indirect.push_back(it->first);
-
-                    it->second.phase = Phase::Indirect;
-                    it->second.deadline_ms = now + INDIRECT_TIMEOUT_MS;
-                    ++it;
-                }
-                else {
-                    escalate_to_suspect.push_back(it->first);
-                    it = probes_.erase(it);
-                }
-            }
+    {
+        std::lock_guard<std::mutex> lk(node_->membership_mu);
+        auto mit = node_->membership.find(target);
+        if (mit != node_->membership.end()) {
+            target_ip = mit->second.ip;
+            compact = speaks_ids(mit->second);
         }
+    }
 
-        // if no ack, ping-req
-        for (const auto& target : escalate_to_indirect) {
+    if (target_ip.empty()) return;
 
-            std::string target_ip;
+    std::string piggy = build_piggy_data(*node_, target, PIGGY_K);
 
-            {
-                std::lock_guard<std::mutex> lk(node_->membership_mu);
-                auto mit = node_->membership.find(target);
-                if (mit != node_->membership.end())
-                    target_ip = mit->second.ip;
-            }
+    std::string msg = make_msg("PING", *node_, piggy, compact);
 
-            if (target_ip.empty())
-                continue;
+    // Registered before sending so a fast ACK finds it.
+    {
+        std::lock_guard<std::mutex> lk(probes_mu_);
+        probes_[target] = {
+            Phase::Direct,
+            now + PING_TIMEOUT_MS,
+            now_us(),
+            target_ip
+        };
+    }
 
-            std::vector<std::string> helpers = rr_peers_;
-            std::shuffle(helpers.begin(), helpers.end(), rr_rng_);
+    send_udp(target_ip, msg);
+    trace_record(TraceKind::ProbeStart, target);
+}
 
-            size_t sent = 0;
+// Dead and tombstoned members get a PING now and then, outside the probe
+// rounds and without a timeout. Its piggyback tells a dead member it is
+// dead, so if it is back it refutes and its ACK revives it here; a
+// tombstoned one is merged straight from the ACK. The ACK's digest then
+// syncs whatever else the two views disagree on.
+void Heartbeat::reprobe(uint64_t now) {
+    const uint64_t every = reprobe_ms.load(std::memory_order_relaxed);
+    if (every == 0 || now < next_reprobe_ms_) return;
+    next_reprobe_ms_ = now + every;
+
+    std::string name;
+    std::string ip;
+    {
+        std::lock_guard<std::mutex> lk(node_->membership_mu);
+        ProbeRound& dead = node_->schedule.dead_round();
+
+        // Alternate between the two when both have candidates.
+        const bool tomb = node_->tombstones.size() && (dead.size() == 0 || ++reprobe_turn_ % 2 == 0);
+        if (tomb) {
+            in_addr a{};
+            a.s_addr = node_->tombstones.random_ipv4(rr_rng_);
+            char buf[INET_ADDRSTRLEN] = {};
+            if (a.s_addr && inet_ntop(AF_INET, &a, buf, sizeof(buf))) ip = buf;
+        } else if (const std::string* t = dead.next(rr_rng_)) {
+            name = *t;
+            auto mit = node_->membership.find(name);
+            if (mit != node_->membership.end()) ip = mit->second.ip;
+        }
+    }
 
-            for (const auto& helper : helpers) {
-                if (helper == target) continue;
-                if (sent >= FANOUT) break;
+    if (ip.empty() || ip == node_->ip) return;
 
-                std::string helper_ip;
+    send_udp(ip, make_msg("PING", *node_, build_piggy_data(*node_, name, PIGGY_K)));
+    reprobes_sent.fetch_add(1, std::memory_order_relaxed);
+    trace_record(TraceKind::Reprobe, name.empty() ? ip : name);
+}
 
-                {
-                    std::lock_guard<std::mutex> lk(node_->membership_mu);
-                    auto mit = node_->membership.find(helper);
-                    if (mit != node_->membership.end())
-                        helper_ip = mit->second.ip;
-                }
+void Heartbeat::tick(uint64_t now) {
+    // timeouts
+    std::vector<std::string> escalate_to_indirect;
+    std::vector<std::string> escalate_to_suspect;
 
-                if (helper_ip.empty())
-                    continue;
+    {
+        std::lock_guard<std::mutex> lk(probes_mu_);
 
-                std::string target_info = target + "@" + target_ip;
-                std::string msg = make_msg("PING-REQ", *node_, target_info);
+        for (auto it = probes_.begin(); it != probes_.end(); ) {
 
-                send_udp(helper_ip, msg);
-                sent++;
+            if (now < it->second.deadline_ms) {
+                ++it;
+                continue;
+            }
+
+            if (it->second.phase == Phase::Direct) {
+                escalate_to_indirect.push_back(it->first);
+
+                it->second.phase = Phase::Indirect;
+                it->second.deadline_ms = now + INDIRECT_TIMEOUT_MS;
+                ++it;
+            }
+            else {
+                escalate_to_suspect.push_back(it->first);
+                it = probes_.erase(it);
             }
         }
+    }
 
-        // if no ack-req, mark as suspect
-        if (!escalate_to_suspect.empty()) {
+    // if no ack, ping-req
+    for (const auto& target : escalate_to_indirect) {
 
+        std::vector<std::pair<std::string, std::string>> reqs;   // (helper ip, msg)
+
+        {
             std::lock_guard<std::mutex> lk(node_->membership_mu);
+            auto tit = node_->membership.find(target);
+            if (tit == node_->membership.end() || tit->second.ip.empty())
+                continue;
 
-            for (const auto& target : escalate_to_suspect) {
+            const std::string& target_ip = tit->second.ip;
+            const std::string& target_id = node_->ids.id_of(target);
 
-                auto mit = node_->membership.find(target);
-                if (mit == node_->membership.end())
+            // A few random candidates from both rounds, nearest first.
+            std::vector<std::string> helpers;
+            node_->schedule.local().sample(PING_REQ_CANDIDATES, rr_rng_, helpers);
+            node_->schedule.remote().sample(PING_REQ_CANDIDATES, rr_rng_, helpers);
+            std::shuffle(helpers.begin(), helpers.end(), rr_rng_);
+            rank_by_proximity(helpers, target);
+
+            for (const auto& helper : helpers) {
+                if (helper == target) continue;
+                if (reqs.size() >= FANOUT) break;
+
+                auto mit = node_->membership.find(helper);
+                if (mit == node_->membership.end() || mit->second.ip.empty())
                     continue;
 
-                if (mit->second.status == MemberStatus::Alive) {
-                    mit->second.status = MemberStatus::Suspect;
-                    mit->second.suspect_since_ms = now;
-                }
+                // The helper only needs the address; the name is informational.
+                const bool compact = speaks_ids(mit->second);
+                std::string target_info = (compact && !target_id.empty() ? "#" + target_id : target)
+                                          + "@" + target_ip;
+                reqs.emplace_back(mit->second.ip, make_msg("PING-REQ", *node_, target_info, compact));
             }
         }
 
-        // membership aging
-        std::vector<std::string> peer_names;
+        for (const auto& [helper_ip, msg] : reqs)
+            send_udp(helper_ip, msg);
 
-        {
-            std::lock_guard<std::mutex> lk(node_->membership_mu);
+        trace_record(TraceKind::EscalateIndirect, target, reqs.size());
+    }
 
-            auto& me = node_->membership[node_->name];
-            me.status = MemberStatus::Alive;
-            me.last_seen_ms = now;
+    // if no ack-req, mark as suspect
+    if (!escalate_to_suspect.empty()) {
 
-            for (auto& [name, info] : node_->membership) {
+        std::lock_guard<std::mutex> lk(node_->membership_mu);
 
-                if (name == node_->name)
-                    continue;
+        for (const auto& target : escalate_to_suspect) {
 
-                if (info.status == MemberStatus::Suspect &&
-                    now - info.suspect_since_ms > SUSPECT_MS) {
-                    info.status = MemberStatus::Dead;
-                }
+            auto mit = node_->membership.find(target);
+            if (mit == node_->membership.end())
+                continue;
 
-                if (info.status != MemberStatus::Dead &&
-                    !info.ip.empty()) {
-                    peer_names.push_back(name);
-                }
+            if (mit->second.status == MemberStatus::Alive) {
+                const MemberState before = state_of(mit->second);
+                mit->second.status = MemberStatus::Suspect;
+                mit->second.suspect_since_ms = now;
+                trace_record(TraceKind::Suspect, target);
+                node_->on_member_change(target, before, &mit->second);
+                node_->dissemination.request_push(target);
             }
         }
+    }
 
-        // shuffled round robin
-        std::sort(peer_names.begin(), peer_names.end());
-        peer_names.erase(std::unique(peer_names.begin(), peer_names.end()),
-                         peer_names.end());
-
-        if (peer_names != rr_peers_) {
-            rr_peers_ = peer_names;
-            rr_idx_ = 0;
-            std::shuffle(rr_peers_.begin(), rr_peers_.end(), rr_rng_);
+    // membership aging: only the suspects whose timeout passed
+    std::string local_target;
+    std::string remote_target;
+    std::string sample_target;
+
+    {
+        std::lock_guard<std::mutex> lk(node_->membership_mu);
+
+        auto self = node_->membership.find(node_->name);
+        if (self != node_->membership.end()) {
+            const MemberState before = state_of(self->second);
+            self->second.status = MemberStatus::Alive;
+            self->second.last_seen_ms = now;
+            if (before.status != MemberStatus::Alive)
+                node_->on_member_change(node_->name, before, &self->second);
         }
 
-        // one direct ping
-        if (!rr_peers_.empty()) {
+        const uint64_t cutoff = now > SUSPECT_MS ? now - SUSPECT_MS : 0;
+        for (const auto& name : node_->schedule.suspects().started_before(cutoff)) {
 
-            if (rr_idx_ >= rr_peers_.size()) {
-                rr_idx_ = 0;
-                std::shuffle(rr_peers_.begin(), rr_peers_.end(), rr_rng_);
-            }
+            auto mit = node_->membership.find(name);
+            if (mit == node_->membership.end() || mit->second.status != MemberStatus::Suspect)
+                continue;
 
-            const std::string target = rr_peers_[rr_idx_++];
+            MemberInfo& info = mit->second;
+            const MemberState before = state_of(info);
+            info.status = MemberStatus::Dead;
+            info.dead_since_ms = now;
+            trace_record(TraceKind::Dead, name);
+            node_->on_member_change(name, before, &info);
+            node_->dissemination.request_push(name);
+        }
 
-            bool already_probing = false;
+        reclaim_dead_members(*node_, now);
+
+        // one direct ping in our zone every tick, one to another zone's
+        // representative every ZONE_REMOTE_EVERY ticks, and from a
+        // representative one to any member of another zone every
+        // ZONE_SAMPLE_EVERY ticks
+        if (const std::string* t = node_->schedule.local().next(rr_rng_))
+            local_target = *t;
+        if (++ticks_ % ZONE_REMOTE_EVERY == 0)
+            if (const std::string* t = node_->schedule.remote().next(rr_rng_))
+                remote_target = *t;
+        if (ticks_ % ZONE_SAMPLE_EVERY == 0 && node_->schedule.is_representative())
+            if (const std::string* t = node_->schedule.sample_remote(rr_rng_))
+                sample_target = *t;
+    }
 
-            {
-                std::lock_guard<std::mutex> lk(probes_mu_);
-                already_probing = probes_.count(target);
-            }
+    push_updates(*node_);
 
-            if (!already_probing) {
+    if (!local_target.empty())
+        probe(local_target, now);
 
-                std::string target_ip;
+    if (!remote_target.empty())
+        probe(remote_target, now);
 
-                {
-                    std::lock_guard<std::mutex> lk(node_->membership_mu);
-                    auto mit = node_->membership.find(target);
-                    if (mit != node_->membership.end())
-                        target_ip = mit->second.ip;
-                }
+    if (!sample_target.empty())
+        probe(sample_target, now);
 
-                if (!target_ip.empty()) {
+    reprobe(now);
 
-                    std::string piggy = build_piggy_data(*node_, target, PIGGY_K);
+    node_->transitions.sample_bandwidth(udp_bytes_sent(), node_->rx_bytes.load());
+}
 
-                    std::string msg = make_msg("PING", *node_, piggy);
-                    send_udp(target_ip, msg);
+void Heartbeat::loop() {
+    using namespace std::chrono;
 
-                    {
-                        std::lock_guard<std::mutex> lk(probes_mu_);
-                        probes_[target] = {
-                            Phase::Direct,
-                            now + PING_TIMEOUT_MS
-                        };
-                    }
-                }
-            }
-        }
+    trace_set_thread_name("heartbeat");
+
+    while (node_ && node_->running.load()) {
+        const uint64_t now = now_ms();
+        tick(now);
 
         // sleep remainder of tick
         const uint64_t time_taken = now_ms() - now;
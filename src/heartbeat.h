@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <random>
@@ -7,6 +8,8 @@
 #include <unordered_map>
 #include <mutex>
 
+#include "membership_config.h"
+
 class Node;
 
 enum class Phase {
@@ -18,6 +21,8 @@ enum class Phase {
 struct Probe {
     Phase phase = Phase::None;
     uint64_t deadline_ms = 0;
+    uint64_t sent_us = 0;
+    std::string ip;         // where the PING went
 };
 
 class Heartbeat {
@@ -25,18 +30,40 @@ public:
     void start(Node& node);
     void stop();
 
+    // One protocol period at `now`. The thread calls it every TICK_MS; a
+    // simulation attaches the node and calls it on virtual time instead.
+    void attach(Node& node) { node_ = &node; }
+    void tick(uint64_t now);
+
     std::unordered_map<std::string, Probe> probes_;
     std::mutex probes_mu_;
 
-    void clear_probe(const std::string& target);
+    // Ends the probe of `target`; returns the round trip in µs when it was
+    // still in the direct phase, else 0.
+    uint64_t clear_probe(const std::string& target);
+
+    // Target of the probe sent to `ip`, "" if none; names an ACK whose
+    // compact header we cannot resolve yet.
+    std::string probe_target_at(const std::string& ip);
+
+    // Interval between re-probes of Dead and tombstoned members; 0 = off.
+    std::atomic<uint64_t> reprobe_ms{REPROBE_MS};
+    std::atomic<uint64_t> reprobes_sent{0};
 
 private:
     void loop();
+    void rank_by_proximity(std::vector<std::string>& helpers, const std::string& target);
+    void probe(const std::string& target, uint64_t now);
+    void reprobe(uint64_t now);
 
     Node* node_ = nullptr;
     std::thread th_;
 
-    std::vector<std::string> rr_peers_;
-    size_t rr_idx_ = 0;
+    // Targets come from node_->schedule: our zone every tick, another
+    // zone's representative every ZONE_REMOTE_EVERY ticks and, while we are
+    // a representative, any remote member every ZONE_SAMPLE_EVERY ticks.
+    uint64_t ticks_ = 0;
+    uint64_t next_reprobe_ms_ = 0;
+    uint64_t reprobe_turn_ = 0;
     std::mt19937 rr_rng_{std::random_device{}()};
 };
\ No newline at end of file
@@ -1,23 +1,162 @@
 #include "join.h"
 
+#include <algorithm>
 #include <chrono>
+#include <mutex>
 #include <thread>
 
+#include "membership_config.h"
 #include "node.h"
+#include "piggyback.h"
 #include "sender.h"
+#include "time_util.h"
+#include "trace.h"
+
+// Candidates kept per refresh for redirects; picked from at random.
+static constexpr size_t REDIRECT_SAMPLE = 32;
+
+uint64_t join_backoff_ms(unsigned attempt, std::mt19937& rng) {
+    uint64_t d = JOIN_RETRY_MIN_MS;
+    for (unsigned i = 0; i < attempt && d < JOIN_RETRY_MAX_MS; i++) d *= 2;
+    d = std::min(d, JOIN_RETRY_MAX_MS);
+
+    std::uniform_int_distribution<uint64_t> dist(d / 2, d);
+    return dist(rng);
+}
 
 void attempt_join_loop(Node& node) {
     using namespace std::chrono_literals;
 
-    while (node.running.load() && node.attempt_join.load() && !node.joined.load()) {
-        for (const auto& seed_ip : node.seeds) {
-            if (!node.running.load() || !node.attempt_join.load() || node.joined.load())
-                break;
+    trace_set_thread_name("join");
+
+    std::mt19937 rng(std::random_device{}());
+
+    auto keep_going = [&]{
+        return node.running.load() && node.attempt_join.load() && !node.joined.load();
+    };
+
+    for (unsigned attempt = 0; keep_going(); attempt++) {
+        // Redirect hints are tried once, then we fall back to the seeds.
+        std::vector<std::string> targets;
+        {
+            std::lock_guard<std::mutex> lk(node.join_hints_mu);
+            targets.swap(node.join_hints);
+        }
+        if (targets.empty()) targets = node.seeds;
+
+        const std::string msg = make_msg("JOIN", node);
+        for (const auto& ip : targets) {
+            if (!keep_going()) break;
+            send_udp(ip, msg);
+        }
+
+        // Sleep in slices so stop() and a WELCOME are noticed promptly.
+        const uint64_t until = now_ms() + join_backoff_ms(attempt, rng);
+        while (keep_going() && now_ms() < until)
+            std::this_thread::sleep_for(50ms);
+    }
+}
+
+JoinAction JoinGate::admit(const std::string& name, uint64_t incarnation, uint64_t now, bool is_seed) {
+    stats_.received++;
 
-            std::string msg = make_msg("JOIN", node);
-            send_udp(seed_ip, msg);
+    if (now - last_purge_ms_ > JOIN_DEDUP_MS) {
+        for (auto it = recent_.begin(); it != recent_.end(); ) {
+            if (now - it->second.at_ms > JOIN_DEDUP_MS) it = recent_.erase(it);
+            else ++it;
         }
+        last_purge_ms_ = now;
+    }
+
+    auto [it, inserted] = recent_.try_emplace(name);
+    if (!inserted && it->second.incarnation == incarnation &&
+        now - it->second.at_ms <= JOIN_DEDUP_MS) {
+        stats_.deduped++;
+        return JoinAction::Drop;
+    }
+    it->second = { incarnation, now };
 
-        std::this_thread::sleep_for(750ms);
+    // Arrival rate over a sliding second, from two fixed one-second windows.
+    if (now - window_start_ms_ >= 2000) {
+        prev_window_count_ = 0;
+        window_count_ = 0;
+        window_start_ms_ = now;
+    } else if (now - window_start_ms_ >= 1000) {
+        prev_window_count_ = window_count_;
+        window_count_ = 0;
+        window_start_ms_ += 1000;
     }
-}
\ No newline at end of file
+    window_count_++;
+
+    const uint64_t into = now - window_start_ms_;
+    const uint64_t rate = window_count_ + prev_window_count_ * (1000 - into) / 1000;
+
+    if (is_seed && rate > JOIN_REDIRECT_RATE) return JoinAction::Redirect;
+    return JoinAction::Welcome;
+}
+
+const std::string& JoinGate::welcome_payload(Node& node, uint64_t now) {
+    if (welcome_valid_ && now - welcome_at_ms_ < JOIN_COALESCE_MS) {
+        stats_.welcomes_reused++;
+        return welcome_;
+    }
+
+    welcome_ = build_piggy_data(node, "", PIGGY_K);
+    welcome_at_ms_ = now;
+    welcome_valid_ = true;
+    stats_.welcomes_built++;
+    return welcome_;
+}
+
+std::string JoinGate::redirect_targets(Node& node, const std::string& joiner, uint64_t now) {
+    if (!candidates_valid_ || now - candidates_at_ms_ >= JOIN_COALESCE_MS) {
+        candidates_.clear();
+        size_t seen = 0;
+
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        for (const auto& [name, info] : node.membership) {
+            if (name == node.name || info.ip.empty()) continue;
+            if (info.status != MemberStatus::Alive) continue;
+            if (std::find(node.seeds.begin(), node.seeds.end(), info.ip) != node.seeds.end()) continue;
+
+            seen++;
+            if (candidates_.size() < REDIRECT_SAMPLE) {
+                candidates_.emplace_back(name, info.ip);
+            } else {
+                std::uniform_int_distribution<size_t> dist(0, seen - 1);
+                const size_t j = dist(rng_);
+                if (j < REDIRECT_SAMPLE) candidates_[j] = { name, info.ip };
+            }
+        }
+
+        candidates_at_ms_ = now;
+        candidates_valid_ = true;
+    }
+
+    std::shuffle(candidates_.begin(), candidates_.end(), rng_);
+
+    std::string out;
+    size_t picked = 0;
+    for (const auto& [name, ip] : candidates_) {
+        if (picked >= JOIN_REDIRECT_K) break;
+        if (name == joiner) continue;
+        if (!out.empty()) out.push_back(',');
+        out += ip;
+        picked++;
+    }
+
+    if (!out.empty()) stats_.redirected++;
+    return out;
+}
+
+void JoinGate::reset() {
+    recent_.clear();
+    last_purge_ms_ = 0;
+    window_start_ms_ = 0;
+    window_count_ = 0;
+    prev_window_count_ = 0;
+    welcome_.clear();
+    welcome_valid_ = false;
+    candidates_.clear();
+    candidates_valid_ = false;
+}
@@ -1,7 +1,70 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class Node;
 
-void attempt_join_loop(Node& node); 
\ No newline at end of file
+void attempt_join_loop(Node& node);
+
+// Delay before join attempt `attempt` (0-based): exponential from
+// JOIN_RETRY_MIN_MS up to JOIN_RETRY_MAX_MS, with jitter in [d/2, d].
+uint64_t join_backoff_ms(unsigned attempt, std::mt19937& rng);
+
+enum class JoinAction {
+    Welcome,
+    Redirect,
+    Drop
+};
+
+struct JoinStats {
+    uint64_t received = 0;
+    uint64_t deduped = 0;
+    uint64_t redirected = 0;
+    uint64_t welcomes_built = 0;
+    uint64_t welcomes_reused = 0;
+};
+
+// Admission control for incoming JOINs. Used from the UdpQueue worker only.
+class JoinGate {
+public:
+    JoinAction admit(const std::string& name, uint64_t incarnation, uint64_t now, bool is_seed);
+
+    // WELCOME piggyback data, rebuilt at most once per JOIN_COALESCE_MS.
+    const std::string& welcome_payload(Node& node, uint64_t now);
+
+    // Comma-separated IPs of up to JOIN_REDIRECT_K alive non-seed members
+    // other than `joiner`; empty if none are known.
+    std::string redirect_targets(Node& node, const std::string& joiner, uint64_t now);
+
+    const JoinStats& stats() const { return stats_; }
+    void reset();
+
+private:
+    struct Recent {
+        uint64_t incarnation = 0;
+        uint64_t at_ms = 0;
+    };
+
+    std::unordered_map<std::string, Recent> recent_;
+    uint64_t last_purge_ms_ = 0;
+
+    uint64_t window_start_ms_ = 0;
+    uint64_t window_count_ = 0;
+    uint64_t prev_window_count_ = 0;
+
+    std::string welcome_;
+    uint64_t welcome_at_ms_ = 0;
+    bool welcome_valid_ = false;
+
+    std::vector<std::pair<std::string, std::string>> candidates_; // (name, ip)
+    uint64_t candidates_at_ms_ = 0;
+    bool candidates_valid_ = false;
+
+    std::mt19937 rng_{std::random_device{}()};
+    JoinStats stats_;
+};
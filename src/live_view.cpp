@@ -0,0 +1,345 @@
+#include "live_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "membership.h"
+#include "node.h"
+#include "string_util.h"
+#include "time_util.h"
+
+static constexpr uint64_t LIVE_TICK_MS    = 100;    // key polling
+static constexpr uint64_t LIVE_REFRESH_MS = 1000;   // LAST_SEEN refresh
+static constexpr size_t   LIVE_NAME_MAX   = 40;
+
+enum class SortBy { Name, State, Inc, Ip, Count };
+
+static const char* sort_name(SortBy s) {
+    switch (s) {
+        case SortBy::Name:  return "name";
+        case SortBy::State: return "state";
+        case SortBy::Inc:   return "inc";
+        case SortBy::Ip:    return "ip";
+        default:            return "?";
+    }
+}
+
+// Status letters a row must have to be shown.
+struct StateFilter {
+    const char* label;
+    const char* states;
+};
+
+static const StateFilter STATE_FILTERS[] = {
+    { "all", "ASDL" }, { "alive", "A" }, { "suspect", "S" }, { "dead", "D" }, { "left", "L" },
+    { "down", "SDL" },
+};
+static constexpr size_t STATE_FILTER_COUNT = sizeof(STATE_FILTERS) / sizeof(STATE_FILTERS[0]);
+
+static const char* status_word(char c) {
+    switch (c) {
+        case 'A': return "Alive";
+        case 'S': return "Suspect";
+        case 'D': return "Dead";
+        case 'L': return "Left";
+        default:  return "?";
+    }
+}
+
+// The view's own copy of the membership, ordered for the current sort.
+class LiveModel {
+public:
+    struct Row {
+        std::string ip;
+        char status = 'A';
+        uint64_t incarnation = 0;
+    };
+
+    void upsert(const std::string& name, const std::string& ip, char status, uint64_t inc) {
+        auto [it, inserted] = rows_.try_emplace(name);
+        if (!inserted) {
+            order_.erase({ key_of(it->second), name });
+            counts_[slot(it->second.status)]--;
+        }
+        if (!ip.empty()) it->second.ip = ip;
+        it->second.status = status;
+        it->second.incarnation = inc;
+        order_.insert({ key_of(it->second), name });
+        counts_[slot(status)]++;
+        name_width_ = std::max(name_width_, std::min(name.size() + 2, LIVE_NAME_MAX));
+    }
+
+    void remove(const std::string& name) {
+        auto it = rows_.find(name);
+        if (it == rows_.end()) return;
+        order_.erase({ key_of(it->second), name });
+        counts_[slot(it->second.status)]--;
+        rows_.erase(it);
+    }
+
+    void set_sort(SortBy s) {
+        sort_ = s;
+        order_.clear();
+        for (const auto& [name, row] : rows_) order_.insert({ key_of(row), name });
+    }
+    SortBy sort() const { return sort_; }
+
+    // Rows [offset, offset + limit) of those passing the filter; `total`
+    // gets the number passing.
+    std::vector<std::pair<std::string, Row>> page(const char* states, const std::string& prefix,
+                                                  size_t offset, size_t limit, size_t& total) const {
+        std::vector<std::pair<std::string, Row>> out;
+        total = 0;
+        for (const auto& [key, name] : order_) {
+            const Row& row = rows_.at(name);
+            if (!std::char_traits<char>::find(states, std::char_traits<char>::length(states), row.status)) continue;
+            if (!prefix.empty() && name.compare(0, prefix.size(), prefix) != 0) continue;
+            if (total >= offset && out.size() < limit) out.emplace_back(name, row);
+            total++;
+        }
+        return out;
+    }
+
+    size_t count(char status) const { return counts_[slot(status)]; }
+    size_t size() const { return rows_.size(); }
+    size_t name_width() const { return name_width_; }
+
+private:
+    static size_t slot(char status) { return status == 'S' ? 1 : status == 'D' ? 2 : status == 'L' ? 3 : 0; }
+
+    std::string key_of(const Row& row) const {
+        char buf[32];
+        switch (sort_) {
+            case SortBy::State:
+                return std::string(1, (char)('0' + slot(row.status)));
+            case SortBy::Inc:
+                snprintf(buf, sizeof(buf), "%020llu", (unsigned long long)row.incarnation);
+                return buf;
+            case SortBy::Ip: {
+                unsigned a = 0, b = 0, c = 0, d = 0;
+                sscanf(row.ip.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d);
+                snprintf(buf, sizeof(buf), "%03u%03u%03u%03u", a, b, c, d);
+                return buf;
+            }
+            default:
+                return "";
+        }
+    }
+
+    std::unordered_map<std::string, Row> rows_;
+    std::set<std::pair<std::string, std::string>> order_;   // (sort key, name)
+    SortBy sort_ = SortBy::Name;
+    size_t counts_[4] = {};
+    size_t name_width_ = 6;
+};
+
+static termios saved_termios;
+
+static bool enter_raw_mode() {
+    const bool tty = tcgetattr(STDIN_FILENO, &saved_termios) == 0;
+    if (tty) {
+        termios raw = saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+    fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+    return tty;
+}
+
+static void leave_raw_mode(bool tty) {
+    if (tty) tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+    int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+    fcntl(STDIN_FILENO, F_SETFL, flags & ~O_NONBLOCK);
+}
+
+static size_t screen_rows() {
+    winsize ws{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0) return ws.ws_row;
+    return 30;
+}
+
+static std::string pad(const std::string& s, size_t w) {
+    if (s.size() >= w) return s.substr(0, w);
+    return s + std::string(w - s.size(), ' ');
+}
+
+void live_view(Node& node, const std::string& args) {
+    size_t filter = 0;
+    std::string prefix;
+    SortBy sort = SortBy::Name;
+
+    size_t pos = 0;
+    std::string tok;
+    while (next_token(args, pos, tok)) {
+        const size_t eq = tok.find('=');
+        const std::string key = tok.substr(0, eq);
+        const std::string val = eq == std::string::npos ? "" : tok.substr(eq + 1);
+        if (key == "state") {
+            for (size_t i = 0; i < STATE_FILTER_COUNT; i++)
+                if (val == STATE_FILTERS[i].label) filter = i;
+        } else if (key == "prefix") {
+            prefix = val;
+        } else if (key == "sort") {
+            for (size_t i = 0; i < (size_t)SortBy::Count; i++)
+                if (val == sort_name((SortBy)i)) sort = (SortBy)i;
+        }
+    }
+
+    // Subscribe before the one full copy so no change falls in between;
+    // replaying an event already reflected in the copy is harmless. The
+    // inbox is shared because a batch may still be running in the handler
+    // after unsubscribe() returns.
+    struct Inbox {
+        std::mutex mu;
+        std::vector<MemberEvent> events;
+    };
+    auto inbox = std::make_shared<Inbox>();
+    const uint64_t sub = node.events.subscribe([inbox](const std::vector<MemberEvent>& batch) {
+        std::lock_guard<std::mutex> lk(inbox->mu);
+        inbox->events.insert(inbox->events.end(), batch.begin(), batch.end());
+    });
+
+    LiveModel model;
+    model.set_sort(sort);
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        for (const auto& [name, info] : node.membership)
+            model.upsert(name, info.ip, status_char(info.status), info.incarnation);
+    }
+
+    const bool tty = enter_raw_mode();
+    std::cout << "\033[?1049h\033[?25l\033[2J" << std::flush;
+
+    std::vector<std::string> shown;      // lines currently on screen
+    size_t page_no = 0;
+    bool editing = false;
+    std::string edit;
+    uint64_t last_refresh = 0;
+    bool dirty = true;
+
+    for (bool running = true; running; ) {
+        {
+            std::vector<MemberEvent> batch;
+            {
+                std::lock_guard<std::mutex> lk(inbox->mu);
+                batch.swap(inbox->events);
+            }
+            for (const auto& e : batch) {
+                if (e.kind == MemberEventKind::Removed) model.remove(e.name);
+                else if (e.kind != MemberEventKind::Meta) model.upsert(e.name, e.ip, e.status, e.incarnation);
+            }
+            if (!batch.empty()) dirty = true;
+        }
+
+        char c = 0;
+        while (read(STDIN_FILENO, &c, 1) == 1) {
+            dirty = true;
+            if (editing) {
+                if (c == '\n' || c == '\r') { editing = false; prefix = edit; page_no = 0; }
+                else if (c == 127 || c == 8) { if (!edit.empty()) edit.pop_back(); }
+                else if (c == 27) editing = false;
+                else if (c > ' ' && c < 127) edit.push_back(c);
+                continue;
+            }
+            switch (c) {
+                case 'q': case 'Q': running = false; break;
+                case 'n': case ' ': page_no++; break;
+                case 'p': case 'b': if (page_no) page_no--; break;
+                case 'g': page_no = 0; break;
+                case 'G': page_no = SIZE_MAX; break;
+                case 's':
+                    model.set_sort((SortBy)(((size_t)model.sort() + 1) % (size_t)SortBy::Count));
+                    page_no = 0;
+                    break;
+                case 'f': filter = (filter + 1) % STATE_FILTER_COUNT; page_no = 0; break;
+                case '/': editing = true; edit = prefix; break;
+                default: break;
+            }
+        }
+        if (!running) break;
+
+        const uint64_t now = now_ms();
+        if (!dirty && now - last_refresh < LIVE_REFRESH_MS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(LIVE_TICK_MS));
+            continue;
+        }
+        dirty = false;
+        last_refresh = now;
+
+        const size_t height = screen_rows();
+        const size_t per_page = height > 8 ? height - 6 : 2;
+
+        size_t total = 0;
+        model.page(STATE_FILTERS[filter].states, prefix, 0, 0, total);
+        const size_t pages = std::max<size_t>((total + per_page - 1) / per_page, 1);
+        page_no = std::min(page_no, pages - 1);
+        auto rows = model.page(STATE_FILTERS[filter].states, prefix, page_no * per_page, per_page, total);
+
+        // LAST_SEEN is not in the event feed; look up just the visible rows.
+        std::vector<uint64_t> last_seen(rows.size(), 0);
+        {
+            std::lock_guard<std::mutex> lk(node.membership_mu);
+            for (size_t i = 0; i < rows.size(); i++) {
+                auto it = node.membership.find(rows[i].first);
+                if (it != node.membership.end()) last_seen[i] = it->second.last_seen_ms;
+            }
+        }
+
+        const size_t nw = model.name_width();
+        std::vector<std::string> lines;
+        lines.push_back("members " + std::to_string(model.size()) +
+                        "  alive " + std::to_string(model.count('A')) +
+                        "  suspect " + std::to_string(model.count('S')) +
+                        "  dead " + std::to_string(model.count('D')) +
+                        "  left " + std::to_string(model.count('L')) +
+                        "  | shown " + std::to_string(total) +
+                        "  state=" + STATE_FILTERS[filter].label +
+                        "  prefix=" + (prefix.empty() ? "-" : prefix) +
+                        "  sort=" + sort_name(model.sort()));
+        lines.push_back(pad("NAME", nw) + "  " + pad("STATE", 7) + "  " + pad("IPV4", 15) + "  " +
+                        pad("LAST_SEEN_MS", 14) + "  INC");
+        lines.push_back(std::string(nw + 2 + 7 + 2 + 15 + 2 + 14 + 2 + 10, '-'));
+        for (size_t i = 0; i < per_page; i++) {
+            if (i >= rows.size()) { lines.emplace_back(); continue; }
+            const auto& [name, row] = rows[i];
+            lines.push_back(pad(name == node.name ? name + " *" : name, nw) + "  " +
+                            pad(status_word(row.status), 7) + "  " + pad(row.ip, 15) + "  " +
+                            pad(std::to_string(last_seen[i]), 14) + "  " + std::to_string(row.incarnation));
+        }
+        lines.push_back("page " + std::to_string(page_no + 1) + "/" + std::to_string(pages));
+        lines.push_back(editing ? "prefix: " + edit + "_"
+                                : "n/p page  g/G first/last  s sort  f state  / prefix  q quit");
+
+        if (lines.size() != shown.size()) {
+            std::cout << "\033[2J";
+            shown.assign(lines.size(), std::string(1, '\0'));
+        }
+
+        std::string out;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (lines[i] == shown[i]) continue;
+            out += "\033[" + std::to_string(i + 1) + ";1H" + lines[i] + "\033[K";
+            shown[i] = lines[i];
+        }
+        std::cout << out << std::flush;
+    }
+
+    node.events.unsubscribe(sub);
+    std::cout << "\033[?25h\033[?1049l" << std::flush;
+    leave_raw_mode(tty);
+    std::cout << "Exited live view.\n";
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+class Node;
+
+// `list live [state=alive|suspect|dead|left|down|all] [prefix=<p>]
+// [sort=name|state|inc|ip]`: a full-screen member table for large views.
+// The table is copied once at start and then kept current from the event
+// bus, so later refreshes lock membership_mu only to read LAST_SEEN for the
+// rows on screen. Each refresh rewrites only the screen lines that changed.
+//
+// Keys: n/p next/previous page, g/G first/last, s next sort order, f next
+// state filter, / name prefix (Enter to apply), q quit.
+void live_view(Node& node, const std::string& args);
@@ -0,0 +1,470 @@
+#include "loadgen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "member_id.h"
+#include "membership_config.h"
+#include "net_util.h"
+#include "node.h"
+#include "piggyback.h"
+#include "string_util.h"
+#include "table_print.h"
+#include "time_util.h"
+
+static const uint16_t PORT = 9000;
+
+enum MsgKind { Ping, Piggy, Join, PingReq, KIND_COUNT };
+static const char* const KIND_NAMES[KIND_COUNT] = { "ping", "piggy", "join", "pingreq" };
+
+struct LoadgenConfig {
+    uint64_t rate = 200;
+    uint64_t max_rate = 51200;
+    uint64_t secs = 3;
+    size_t members = 1000;
+    size_t piggy = 40;
+    double stop_loss = 20.0;
+    unsigned mix[KIND_COUNT] = { 60, 20, 10, 10 };
+    std::string from;
+};
+
+static bool parse_mix(const std::string& s, unsigned (&mix)[KIND_COUNT]) {
+    unsigned out[KIND_COUNT] = {};
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t comma = s.find(',', start);
+        if (comma == std::string::npos) comma = s.size();
+        const std::string item = s.substr(start, comma - start);
+        start = comma + 1;
+
+        const size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        const std::string kind = item.substr(0, colon);
+        auto it = std::find_if(std::begin(KIND_NAMES), std::end(KIND_NAMES),
+                               [&](const char* k) { return kind == k; });
+        if (it == std::end(KIND_NAMES)) return false;
+        try { out[it - std::begin(KIND_NAMES)] = (unsigned)std::stoul(item.substr(colon + 1)); }
+        catch (...) { return false; }
+    }
+
+    if (std::all_of(std::begin(out), std::end(out), [](unsigned w) { return w == 0; })) return false;
+    std::copy(std::begin(out), std::end(out), std::begin(mix));
+    return true;
+}
+
+static bool parse_args(const std::vector<std::string>& args, LoadgenConfig& cfg) {
+    for (const auto& arg : args) {
+        const size_t eq = arg.find('=');
+        if (eq == std::string::npos) return false;
+        const std::string key = arg.substr(0, eq);
+        const std::string val = arg.substr(eq + 1);
+
+        try {
+            if (key == "rate") cfg.rate = std::stoull(val);
+            else if (key == "max") cfg.max_rate = std::stoull(val);
+            else if (key == "secs") cfg.secs = std::stoull(val);
+            else if (key == "members") cfg.members = std::stoull(val);
+            else if (key == "piggy") cfg.piggy = std::stoull(val);
+            else if (key == "stop_loss") cfg.stop_loss = std::stod(val);
+            else if (key == "from") cfg.from = val;
+            else if (key == "mix") { if (!parse_mix(val, cfg.mix)) return false; }
+            else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    return cfg.rate > 0 && cfg.max_rate >= cfg.rate && cfg.secs > 0 && cfg.members > 0 &&
+           is_valid_ipv4(cfg.from);
+}
+
+struct VirtualMember {
+    std::string name;
+    uint64_t inc = 0;
+    uint64_t ping_sent_us = 0;      // 0 when no PING is outstanding
+    MsgKind ping_kind = Ping;
+};
+
+struct StepResult {
+    uint64_t offered = 0;
+    double sent_pps = 0;
+    uint64_t sent[KIND_COUNT] = {};
+    uint64_t replied[KIND_COUNT] = {};
+    uint64_t late = 0;
+    uint64_t throttled = 0;
+    std::vector<uint32_t> lat_us;
+
+    uint64_t total_sent() const {
+        uint64_t n = 0;
+        for (uint64_t s : sent) n += s;
+        return n;
+    }
+    uint64_t total_replied() const {
+        uint64_t n = 0;
+        for (uint64_t r : replied) n += r;
+        return n;
+    }
+};
+
+static double loss_pct(uint64_t sent, uint64_t replied) {
+    return sent ? 100.0 * (double)(sent - std::min(sent, replied)) / (double)sent : 0.0;
+}
+
+class LoadGen {
+public:
+    LoadGen(const LoadgenConfig& cfg, const std::string& target, int sock)
+        : cfg_(cfg), sock_(sock) {
+        dst_.sin_family = AF_INET;
+        dst_.sin_port = htons(PORT);
+        inet_pton(AF_INET, target.c_str(), &dst_.sin_addr);
+
+        // Newer than any earlier run, so tombstones and Left entries from
+        // it do not hold the members back.
+        const uint64_t inc = wall_ms() / 1000;
+        const std::string host = get_hostname();
+        for (size_t i = 0; i < cfg.members; i++) {
+            VirtualMember vm;
+            vm.name = host + "-lg" + std::to_string(i);
+            vm.inc = inc;
+            by_id_[member_id(vm.name, cfg.from)] = i;
+            members_.push_back(std::move(vm));
+        }
+
+        weights_ = std::discrete_distribution<int>(std::begin(cfg.mix), std::end(cfg.mix));
+    }
+
+    void start_receiver() {
+        stop_.store(false);
+        rx_ = std::thread(&LoadGen::receive_loop, this);
+    }
+
+    void stop_receiver() {
+        stop_.store(true);
+        if (rx_.joinable()) rx_.join();
+    }
+
+    // Sends one message to each virtual member's name so the target knows
+    // them all before the first step.
+    void introduce() {
+        paced(members_.size(), [&](size_t i) { send(header("JOIN", members_[i])); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(LOADGEN_DRAIN_MS));
+        std::lock_guard<std::mutex> lk(mu_);
+        reset_locked();
+    }
+
+    StepResult run_step(uint64_t rate) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            reset_locked();
+            step_ = StepResult{};
+            step_.offered = rate;
+        }
+
+        const uint64_t start = now_us();
+        const uint64_t end = start + cfg_.secs * 1000000;
+        uint64_t done = 0;
+        uint64_t now = start;
+        while ((now = now_us()) < end) {
+            const uint64_t due = (now - start) * rate / 1000000;
+            for (; done < due; done++) send_one();
+            std::this_thread::sleep_for(std::chrono::microseconds(LOADGEN_PACE_US));
+        }
+        const double elapsed_s = (double)(now_us() - start) / 1e6;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(LOADGEN_DRAIN_MS));
+
+        std::lock_guard<std::mutex> lk(mu_);
+        step_.sent_pps = (double)step_.total_sent() / elapsed_s;
+        return step_;
+    }
+
+    void leave_all() {
+        paced(members_.size(), [&](size_t i) {
+            const VirtualMember& vm = members_[i];
+            MemberInfo left;
+            left.ip = cfg_.from;
+            left.status = MemberStatus::Left;
+            left.incarnation = vm.inc;
+            send(header("LEAVE", vm) + " " + make_entry(vm.name, left));
+        });
+    }
+
+private:
+    std::string header(const char* type, const VirtualMember& vm) const {
+        return std::string(type) + " " + vm.name + " " + cfg_.from + " " + std::to_string(vm.inc);
+    }
+
+    // Calls send_i(0..n-1) at the first step's rate.
+    template <typename F>
+    void paced(size_t n, F send_i) {
+        const uint64_t start = now_us();
+        size_t done = 0;
+        while (done < n) {
+            const uint64_t due = std::min<uint64_t>(n, (now_us() - start) * cfg_.rate / 1000000 + 1);
+            for (; done < due; done++) send_i(done);
+            std::this_thread::sleep_for(std::chrono::microseconds(LOADGEN_PACE_US));
+        }
+    }
+
+    void send(const std::string& msg) {
+        sendto(sock_, msg.data(), msg.size(), 0, (const sockaddr*)&dst_, sizeof(dst_));
+    }
+
+    // A member with no PING in flight; one unanswered for PING_TIMEOUT_MS
+    // counts as free again (its PING is lost).
+    VirtualMember* free_member(uint64_t now) {
+        std::uniform_int_distribution<size_t> pick(0, members_.size() - 1);
+        for (int tries = 0; tries < 8; tries++) {
+            VirtualMember& vm = members_[pick(rng_)];
+            if (!vm.ping_sent_us || now - vm.ping_sent_us > PING_TIMEOUT_MS * 1000) return &vm;
+        }
+        return nullptr;
+    }
+
+    std::string piggy_csv(const VirtualMember& from, size_t budget) {
+        std::uniform_int_distribution<size_t> pick(0, members_.size() - 1);
+        std::string out;
+        for (size_t i = 0; i < cfg_.piggy; i++) {
+            const VirtualMember& vm = members_[pick(rng_)];
+            if (&vm == &from) continue;
+
+            MemberInfo info;
+            info.ip = cfg_.from;
+            info.incarnation = vm.inc;
+            const std::string e = make_entry(vm.name, info);
+            if (out.size() + e.size() + 1 > budget) break;
+            if (!out.empty()) out.push_back(',');
+            out += e;
+        }
+        return out;
+    }
+
+    void send_one() {
+        const uint64_t now = now_us();
+        std::string msg;
+        MsgKind kind;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            kind = (MsgKind)weights_(rng_);
+            std::uniform_int_distribution<size_t> pick(0, members_.size() - 1);
+
+            switch (kind) {
+                case Ping:
+                case Piggy: {
+                    VirtualMember* vm = free_member(now);
+                    if (!vm) { step_.throttled++; return; }
+                    vm->ping_sent_us = now;
+                    vm->ping_kind = kind;
+                    msg = header("PING", *vm);
+                    if (kind == Piggy) msg += " " + piggy_csv(*vm, LOADGEN_MAX_DATAGRAM - msg.size() - 1);
+                    break;
+                }
+                case Join: {
+                    // A new incarnation every time, or the target's join
+                    // gate would drop it as a retry.
+                    VirtualMember& vm = members_[pick(rng_)];
+                    vm.inc++;
+                    msg = header("JOIN", vm);
+                    pending_[Join].push_back(now);
+                    break;
+                }
+                default: {
+                    const VirtualMember& vm = members_[pick(rng_)];
+                    const VirtualMember& subject = members_[pick(rng_)];
+                    msg = header("PING-REQ", vm) + " " + subject.name + "@" + cfg_.from;
+                    pending_[PingReq].push_back(now);
+                    break;
+                }
+            }
+            step_.sent[kind]++;
+        }
+        send(msg);
+    }
+
+    void record_locked(MsgKind kind, uint64_t sent_us, uint64_t now) {
+        const uint64_t lat = now - sent_us;
+        if (lat > PING_TIMEOUT_MS * 1000) {
+            step_.late++;
+            return;
+        }
+        step_.replied[kind]++;
+        step_.lat_us.push_back((uint32_t)lat);
+    }
+
+    void handle(const std::string& msg, uint64_t now) {
+        std::string type;
+        size_t pos = 0;
+        next_token(msg, pos, type);
+
+        std::lock_guard<std::mutex> lk(mu_);
+        if (type == "ACK") {
+            std::string tok;
+            while (next_token(msg, pos, tok)) {
+                if (tok.compare(0, 2, "I=") != 0) continue;
+                auto it = by_id_.find(tok.substr(2));
+                if (it == by_id_.end()) return;
+                VirtualMember& vm = members_[it->second];
+                if (!vm.ping_sent_us) return;
+                record_locked(vm.ping_kind, vm.ping_sent_us, now);
+                vm.ping_sent_us = 0;
+                return;
+            }
+        } else if (type == "WELCOME" || type == "REDIRECT" || type == "PING-REQ2") {
+            const MsgKind kind = type == "PING-REQ2" ? PingReq : Join;
+            std::deque<uint64_t>& q = pending_[kind];
+            if (q.empty()) return;
+            record_locked(kind, q.front(), now);
+            q.pop_front();
+        }
+    }
+
+    void receive_loop() {
+        timeval tv{};
+        tv.tv_usec = 20 * 1000;
+        setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        char buf[65536];
+        while (!stop_.load()) {
+            const ssize_t n = recv(sock_, buf, sizeof(buf), 0);
+            if (n > 0) handle(std::string(buf, (size_t)n), now_us());
+        }
+    }
+
+    void reset_locked() {
+        for (auto& vm : members_) vm.ping_sent_us = 0;
+        for (auto& q : pending_) q.clear();
+    }
+
+    const LoadgenConfig cfg_;
+    const int sock_;
+    sockaddr_in dst_{};
+
+    std::mutex mu_;
+    std::vector<VirtualMember> members_;
+    std::unordered_map<std::string, size_t> by_id_;
+    std::deque<uint64_t> pending_[KIND_COUNT];
+    StepResult step_;
+    std::discrete_distribution<int> weights_;
+    std::mt19937 rng_{std::random_device{}()};
+
+    std::atomic<bool> stop_{false};
+    std::thread rx_;
+};
+
+static int open_socket() {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) { perror("loadgen socket"); return -1; }
+
+    int rcvbuf = 8 << 20;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("loadgen bind (is a node running on this host?)");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static std::string fmt_ms(double us) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.2f", us / 1000.0);
+    return buf;
+}
+
+static std::string fmt_pct(double v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f", v);
+    return buf;
+}
+
+static double percentile(const std::vector<uint32_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t)(q * (double)sorted.size()))];
+}
+
+int run_loadgen(const std::string& target, const std::vector<std::string>& args) {
+    LoadgenConfig cfg;
+    cfg.from = detect_local_ip();
+    if (!is_valid_ipv4(target) || !parse_args(args, cfg)) {
+        std::cerr << "Usage: gds loadgen <target_ip> [rate=<pps>] [max=<pps>] [secs=<s>] [members=<n>]\n"
+                  << "                   [piggy=<n>] [mix=ping:60,piggy:20,join:10,pingreq:10]\n"
+                  << "                   [stop_loss=<pct>] [from=<ip>]\n";
+        return 2;
+    }
+
+    const int sock = open_socket();
+    if (sock < 0) return 1;
+
+    LoadGen gen(cfg, target, sock);
+    gen.start_receiver();
+
+    std::cout << "loadgen: " << cfg.members << " virtual members at " << cfg.from << " -> " << target
+              << ", " << cfg.secs << " s per step\n";
+    gen.introduce();
+
+    std::vector<std::vector<std::string>> rows;
+    uint64_t best = 0;
+    double best_p99 = 0;
+
+    for (uint64_t rate = cfg.rate; rate <= cfg.max_rate; rate *= 2) {
+        StepResult r = gen.run_step(rate);
+        std::sort(r.lat_us.begin(), r.lat_us.end());
+
+        const double loss = loss_pct(r.total_sent(), r.total_replied());
+        const double p99 = percentile(r.lat_us, 0.99);
+
+        std::vector<std::string> row = {
+            std::to_string(rate),
+            fmt_pct(r.sent_pps),
+            fmt_pct(loss),
+        };
+        for (int k = 0; k < KIND_COUNT; k++) row.push_back(fmt_pct(loss_pct(r.sent[k], r.replied[k])));
+        row.push_back(std::to_string(r.late));
+        row.push_back(fmt_ms(percentile(r.lat_us, 0.5)));
+        row.push_back(fmt_ms(percentile(r.lat_us, 0.9)));
+        row.push_back(fmt_ms(p99));
+        row.push_back(fmt_ms(r.lat_us.empty() ? 0 : r.lat_us.back()));
+        row.push_back(std::to_string(r.throttled));
+        rows.push_back(std::move(row));
+
+        std::cout << "  " << rate << " pps offered: sent " << r.total_sent() << ", loss "
+                  << fmt_pct(loss) << "%, p99 " << fmt_ms(p99) << " ms\n" << std::flush;
+
+        if (loss < LOADGEN_OK_LOSS) {
+            best = rate;
+            best_p99 = p99;
+        }
+        if (loss > cfg.stop_loss) break;
+    }
+
+    gen.leave_all();
+    gen.stop_receiver();
+    close(sock);
+
+    print_table({ "OFFERED_PPS", "SENT_PPS", "LOSS_%", "PING_%", "PIGGY_%", "JOIN_%", "PINGREQ_%",
+                  "LATE", "P50_MS", "P90_MS", "P99_MS", "MAX_MS", "THROTTLED" }, rows);
+    if (best)
+        std::cout << "Highest step under " << LOADGEN_OK_LOSS << "% loss: " << best << " pps (p99 "
+                  << fmt_ms(best_p99) << " ms)\n";
+    else
+        std::cout << "Every step lost " << LOADGEN_OK_LOSS << "% or more\n";
+    return 0;
+}
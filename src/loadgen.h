@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// `gds loadgen <target_ip> [key=value ...]` finds a node's breaking point.
+// It impersonates `members` virtual members at this host's address and
+// sends the target a mix of PING, piggyback-heavy PING, JOIN and PING-REQ,
+// doubling the rate every step and recording reply latency and loss, until
+// a step loses more than `stop_loss` percent or `max` is reached:
+//
+//   rate=<pps>       first step (200)          max=<pps>      last step (51200)
+//   secs=<s>         length of a step (3)      members=<n>    virtual members (1000)
+//   piggy=<n>        entries per heavy PING (40)
+//   mix=ping:60,piggy:20,join:10,pingreq:10    relative weights
+//   stop_loss=<pct>  (20)                      from=<ip>      our address
+//
+// A reply later than PING_TIMEOUT_MS counts as lost, as it would for a real
+// prober. ACKs are matched to their PING by the sender ID they echo in I=;
+// WELCOME/REDIRECT (for JOIN) and PING-REQ2 (for PING-REQ) are matched in
+// order. Replies come to UDP port 9000, so no node may run on this host or
+// network namespace. The virtual members do not answer probes, so the
+// cluster suspects them during a run; they send LEAVE when it ends.
+
+inline constexpr uint64_t LOADGEN_PACE_US  = 500;     // sender wakeups
+inline constexpr uint64_t LOADGEN_DRAIN_MS = 2500;    // wait for replies after a step
+inline constexpr double   LOADGEN_OK_LOSS  = 1.0;     // percent, for the summary
+inline constexpr size_t   LOADGEN_MAX_DATAGRAM = 1900;
+
+int run_loadgen(const std::string& target, const std::vector<std::string>& args);
@@ -0,0 +1,311 @@
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "time_util.h"
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "ring size must be a power of two");
+
+static constexpr size_t LOG_SITES = 256;
+
+namespace {
+
+struct Slot {
+    std::atomic<uint64_t> seq{0};
+    uint64_t wall_ms = 0;
+    uint16_t len = 0;
+    LogLevel level = LogLevel::Info;
+    char text[LOG_LINE_MAX];
+};
+
+struct Site {
+    std::atomic<const char*> key{nullptr};     // format string, or log_errno's `what`
+    std::atomic<uint64_t> second{0};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+struct Logger {
+    Logger() {
+        for (size_t i = 0; i < LOG_RING_SLOTS; i++) ring[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    Slot ring[LOG_RING_SLOTS];
+    alignas(64) std::atomic<uint64_t> tail{0};   // next slot to claim
+    alignas(64) uint64_t head = 0;               // consumer only
+
+    Site sites[LOG_SITES];
+
+    std::atomic<LogLevel> level{LogLevel::Info};
+    std::atomic<uint32_t> site_rate{LOG_SITE_RATE};
+    std::atomic<bool> running{false};
+    std::thread th;
+
+    std::mutex sink_mu;       // held while writing; guards fd/path
+    int fd = STDOUT_FILENO;
+    bool own_fd = false;
+    std::string path;
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> suppressed{0};
+};
+
+Logger g_log;
+
+}
+
+const char* log_level_name(LogLevel lvl) {
+    switch (lvl) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info:  return "info";
+        case LogLevel::Warn:  return "warn";
+        case LogLevel::Error: return "error";
+        case LogLevel::Off:   return "off";
+        default:              return "?";
+    }
+}
+
+bool log_level_from_name(const std::string& s, LogLevel& out) {
+    for (LogLevel l : { LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error, LogLevel::Off }) {
+        if (s == log_level_name(l)) { out = l; return true; }
+    }
+    return false;
+}
+
+void log_set_level(LogLevel lvl) { g_log.level.store(lvl, std::memory_order_relaxed); }
+LogLevel log_level() { return g_log.level.load(std::memory_order_relaxed); }
+
+static void close_sink_locked() {
+    if (g_log.own_fd) close(g_log.fd);
+    g_log.fd = STDOUT_FILENO;
+    g_log.own_fd = false;
+    g_log.path.clear();
+}
+
+bool log_set_file(const std::string& path) {
+    if (path.empty() || path == "-") {
+        std::lock_guard<std::mutex> lk(g_log.sink_mu);
+        close_sink_locked();
+        return true;
+    }
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    std::lock_guard<std::mutex> lk(g_log.sink_mu);
+    close_sink_locked();
+    g_log.fd = fd;
+    g_log.own_fd = true;
+    g_log.path = path;
+    return true;
+}
+
+std::string log_file() {
+    std::lock_guard<std::mutex> lk(g_log.sink_mu);
+    return g_log.path.empty() ? "stdout" : g_log.path;
+}
+
+void log_set_fd(int fd) {
+    std::lock_guard<std::mutex> lk(g_log.sink_mu);
+    close_sink_locked();
+    g_log.fd = fd;
+}
+
+void log_set_site_rate(uint32_t per_second) {
+    g_log.site_rate.store(per_second, std::memory_order_relaxed);
+}
+
+LogStats log_stats() {
+    return {
+        g_log.written.load(std::memory_order_relaxed),
+        g_log.dropped.load(std::memory_order_relaxed),
+        g_log.suppressed.load(std::memory_order_relaxed)
+    };
+}
+
+// Counts this call against its site's budget for the current second;
+// returns false if over it. `carried` gets the number suppressed since the
+// site last got through.
+static bool admit(const char* key, uint32_t& carried) {
+    carried = 0;
+    const uint32_t rate = g_log.site_rate.load(std::memory_order_relaxed);
+    if (rate == 0) return true;
+
+    const size_t start = (size_t)(((uintptr_t)key >> 4) * 0x9E3779B97F4A7C15ULL >> 56) % LOG_SITES;
+
+    Site* site = nullptr;
+    for (size_t i = 0; i < LOG_SITES; i++) {
+        Site& s = g_log.sites[(start + i) % LOG_SITES];
+        const char* cur = s.key.load(std::memory_order_acquire);
+        if (cur == key) { site = &s; break; }
+        if (cur == nullptr) {
+            if (s.key.compare_exchange_strong(cur, key) || cur == key) { site = &s; break; }
+        }
+    }
+    if (!site) return true;   // table full: no limit
+
+    const uint64_t sec = now_ms() / 1000;
+    uint64_t seen = site->second.load(std::memory_order_relaxed);
+    if (seen != sec && site->second.compare_exchange_strong(seen, sec))
+        site->count.store(0, std::memory_order_relaxed);
+
+    if (site->count.fetch_add(1, std::memory_order_relaxed) >= rate) {
+        site->suppressed.fetch_add(1, std::memory_order_relaxed);
+        g_log.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    carried = site->suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+static size_t format_prefix(char* out, size_t cap, uint64_t wall, LogLevel lvl) {
+    const time_t secs = (time_t)(wall / 1000);
+    tm t{};
+    localtime_r(&secs, &t);
+    const int n = snprintf(out, cap, "%02d:%02d:%02d.%03u %-5s ", t.tm_hour, t.tm_min, t.tm_sec,
+                           (unsigned)(wall % 1000), log_level_name(lvl));
+    return n > 0 ? (size_t)n : 0;
+}
+
+static void write_all(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        const ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return;
+        p += w;
+        n -= (size_t)w;
+    }
+}
+
+// Drains the ring into one write; false if it was empty.
+static bool drain() {
+    std::string batch;
+    char prefix[48];
+
+    while (true) {
+        Slot& s = g_log.ring[g_log.head & (LOG_RING_SLOTS - 1)];
+        if (s.seq.load(std::memory_order_acquire) != g_log.head + 1) break;
+
+        batch.append(prefix, format_prefix(prefix, sizeof(prefix), s.wall_ms, s.level));
+        batch.append(s.text, s.len);
+        batch.push_back('\n');
+
+        s.seq.store(g_log.head + LOG_RING_SLOTS, std::memory_order_release);
+        g_log.head++;
+        g_log.written.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (batch.empty()) return false;
+
+    std::lock_guard<std::mutex> lk(g_log.sink_mu);
+    write_all(g_log.fd, batch.data(), batch.size());
+    return true;
+}
+
+static void log_loop() {
+    while (g_log.running.load(std::memory_order_acquire)) {
+        if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(LOG_POLL_MS));
+    }
+    drain();
+}
+
+void log_start() {
+    if (g_log.running.exchange(true)) return;
+    g_log.th = std::thread(log_loop);
+}
+
+void log_stop() {
+    if (!g_log.running.exchange(false)) return;
+    if (g_log.th.joinable()) g_log.th.join();
+}
+
+// `site` keys the rate limit: the format string, except for log_errno.
+static void vlog(LogLevel lvl, const char* site, const char* fmt, va_list ap) {
+    if (lvl < g_log.level.load(std::memory_order_relaxed)) return;
+
+    uint32_t carried = 0;
+    if (!admit(site, carried)) return;
+
+    char text[LOG_LINE_MAX];
+    int n = vsnprintf(text, sizeof(text), fmt, ap);
+    if (n < 0) return;
+    size_t len = std::min((size_t)n, sizeof(text) - 1);
+    if (carried) {
+        const int m = snprintf(text + len, sizeof(text) - len, " (+%u suppressed)", carried);
+        if (m > 0) len = std::min(len + (size_t)m, sizeof(text) - 1);
+    }
+
+    const uint64_t wall = wall_ms();
+
+    if (!g_log.running.load(std::memory_order_acquire)) {
+        char prefix[48];
+        std::string line(prefix, format_prefix(prefix, sizeof(prefix), wall, lvl));
+        line.append(text, len);
+        line.push_back('\n');
+        std::lock_guard<std::mutex> lk(g_log.sink_mu);
+        write_all(g_log.fd, line.data(), line.size());
+        g_log.written.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t pos = g_log.tail.load(std::memory_order_relaxed);
+    Slot* s = nullptr;
+    while (true) {
+        s = &g_log.ring[pos & (LOG_RING_SLOTS - 1)];
+        const uint64_t seq = s->seq.load(std::memory_order_acquire);
+        const int64_t diff = (int64_t)seq - (int64_t)pos;
+        if (diff == 0) {
+            if (g_log.tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            g_log.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = g_log.tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::memcpy(s->text, text, len);
+    s->len = (uint16_t)len;
+    s->level = lvl;
+    s->wall_ms = wall;
+    s->seq.store(pos + 1, std::memory_order_release);
+}
+
+void log_write(LogLevel lvl, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vlog(lvl, fmt, fmt, ap);
+    va_end(ap);
+}
+
+void log_debug(const char* fmt, ...) { va_list ap; va_start(ap, fmt); vlog(LogLevel::Debug, fmt, fmt, ap); va_end(ap); }
+void log_info(const char* fmt, ...)  { va_list ap; va_start(ap, fmt); vlog(LogLevel::Info,  fmt, fmt, ap); va_end(ap); }
+void log_warn(const char* fmt, ...)  { va_list ap; va_start(ap, fmt); vlog(LogLevel::Warn,  fmt, fmt, ap); va_end(ap); }
+void log_error(const char* fmt, ...) { va_list ap; va_start(ap, fmt); vlog(LogLevel::Error, fmt, fmt, ap); va_end(ap); }
+
+static void log_site(LogLevel lvl, const char* site, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vlog(lvl, site, fmt, ap);
+    va_end(ap);
+}
+
+// Each `what` is a site of its own, so a flood of one error does not hide
+// the others.
+void log_errno(const char* what) {
+    const int err = errno;
+    char buf[128];
+    const char* msg = strerror_r(err, buf, sizeof(buf));
+    log_site(LogLevel::Warn, what, "%s: %s", what, msg);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Leveled, rate-limited logging that never blocks the caller. A log call
+// formats into a slot of a fixed lock-free ring (a bounded MPMC queue with
+// per-slot sequence numbers) and returns; a background thread drains the
+// ring to stdout or a file. When the ring is full, because the sink is slow
+// or stuck, the message is dropped and counted instead of waiting.
+//
+// Each call site (its format string) may log LOG_SITE_RATE messages per
+// second; the rest are counted and reported with the site's next message.
+//
+// Before log_start(), or after log_stop(), messages are written directly.
+
+inline constexpr size_t   LOG_RING_SLOTS = 1024;   // power of two
+inline constexpr size_t   LOG_LINE_MAX   = 240;
+inline constexpr uint32_t LOG_SITE_RATE  = 10;     // per call site per second
+inline constexpr uint64_t LOG_POLL_MS    = 20;
+
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error, Off };
+
+const char* log_level_name(LogLevel lvl);
+bool log_level_from_name(const std::string& s, LogLevel& out);
+
+void log_start();
+void log_stop();                      // drains what is queued
+void log_set_level(LogLevel lvl);
+LogLevel log_level();
+
+// "" or "-" for stdout. False if the file could not be opened.
+bool log_set_file(const std::string& path);
+std::string log_file();
+
+// Used by the benchmark; the caller keeps ownership of `fd`.
+void log_set_fd(int fd);
+
+// Per-site messages per second; 0 disables the limit.
+void log_set_site_rate(uint32_t per_second);
+
+void log_write(LogLevel lvl, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+void log_debug(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+void log_info(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+void log_warn(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+void log_error(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// perror() replacement: "<what>: <strerror(errno)>" at Warn, rate limited
+// per `what` (pass a string literal).
+void log_errno(const char* what);
+
+struct LogStats {
+    uint64_t written = 0;
+    uint64_t dropped = 0;      // ring full
+    uint64_t suppressed = 0;   // over the per-site rate
+};
+
+LogStats log_stats();
@@ -1,11 +1,23 @@
+#include <csignal>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <pthread.h>
+
+#include "bench.h"
 #include "commands.h"
+#include "loadgen.h"
+#include "log.h"
 #include "node.h"
+#include "shm_view.h"
 #include "string_util.h"
+#include "table_print.h"
+#include "trace.h"
 
 static std::vector<std::string> load_seeds_file(const std::string& path) {
     std::vector<std::string> seeds;
@@ -21,11 +33,133 @@ static std::vector<std::string> load_seeds_file(const std::string& path) {
     return seeds;
 }
 
-int main() {
+// Reads the table a local node publishes, the way other processes would.
+static int dump_shm_view(const char* name) {
+    ShmView view;
+    if (!view.open(name)) {
+        std::cerr << "No membership published at " << name << "\n";
+        return 1;
+    }
+
+    std::vector<ShmMember> members;
+    uint64_t publish = 0;
+    if (!view.snapshot(members, &publish)) {
+        std::cerr << "Could not read a consistent table\n";
+        return 1;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& m : members) {
+        rows.push_back({ m.name, m.ip, std::string(1, m.status),
+                         std::to_string(m.incarnation), std::to_string(m.last_seen_wall_ms) });
+    }
+    std::cout << "Published by " << view.self_name() << "@" << view.self_ip()
+              << (view.live() ? "" : " (stopped)") << ", publish " << publish << "\n";
+    print_table({ "NAME", "IPV4", "STATE", "INC", "LAST_SEEN_WALL_MS" }, rows);
+    return 0;
+}
+
+static sigset_t shutdown_signals() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    return set;
+}
+
+// Taken by whichever of main and the signal thread tears down first and
+// never released, so the other cannot stop the node or the logger again,
+// or use them after main has returned.
+static std::mutex g_shutdown_mu;
+
+static void shut_down(Node& node) {
+    g_shutdown_mu.lock();
+    node.stop();
+    log_stop();
+    std::cout << "Goodbye!\n" << std::flush;
+}
+
+// SIGINT and SIGTERM stop the node the way `quit` does, so it leaves with a
+// LEAVE instead of waiting to be detected. The signals are blocked in every
+// thread and taken by one waiter, since the CLI may sit in a stdin read.
+static void watch_shutdown_signals(Node& node) {
+    std::thread([&node] {
+        const sigset_t set = shutdown_signals();
+        int sig = 0;
+        if (sigwait(&set, &sig) != 0) return;
+
+        shut_down(node);
+        std::_Exit(0);
+    }).detach();
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "trace") {
+        if (argc < 3) {
+            std::cerr << "Usage: gds trace <file>\n";
+            return 2;
+        }
+        if (!trace_decode(argv[2], std::cout)) {
+            std::cerr << "Could not decode " << argv[2] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "events") {
+        if (argc < 3) {
+            std::cerr << "Usage: gds events <ip> [since_seq]\n";
+            return 2;
+        }
+        uint64_t since = 0;
+        if (argc >= 4) {
+            try { since = std::stoull(argv[3]); } catch (...) { since = 0; }
+        }
+        if (!stream_events(argv[2], since, std::cout)) {
+            std::cerr << "Could not connect to " << argv[2] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "shm") {
+        return dump_shm_view(argc >= 3 ? argv[2] : SHM_NAME);
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        if (argc < 3) return run_bench("", {});
+        return run_bench(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "loadgen") {
+        if (argc < 3) return run_loadgen("", {});
+        return run_loadgen(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    }
+
+    // Before any thread starts, so all of them inherit the mask.
+    const sigset_t sigs = shutdown_signals();
+    pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+
+    trace_set_thread_name("cli");
+    log_start();
+
     bool auto_start = true;
 
     std::vector<std::string> seeds = load_seeds_file("seeds.conf");
     Node node(std::move(seeds));
+
+    // discovery.conf: "<group>[:<port>]" enables multicast discovery.
+    std::vector<std::string> discovery = load_seeds_file(DISCOVERY_PATH);
+    if (!discovery.empty()) {
+        DiscoveryConfig cfg;
+        if (parse_discovery_addr(discovery[0], cfg)) node.discovery.configure(cfg);
+        else std::cerr << "Ignoring " << DISCOVERY_PATH << ": bad group " << discovery[0] << "\n";
+    }
+
+    node.broadcasts.on_deliver([](const BroadcastMessage& m) {
+        log_info("[broadcast from %s] %s", m.origin.c_str(), m.payload.c_str());
+    });
+    watch_shutdown_signals(node);
     if (auto_start) node.start();
 
     std::cout << "Welcome to GDS! Use \"help\" to view commands.\n";
@@ -44,7 +178,6 @@ int main() {
         res = handle_command(cmd, args, node);
     }
 
-    node.stop();
-    std::cout << "Goodbye!\n";
+    shut_down(node);
     return 0;
 }
\ No newline at end of file
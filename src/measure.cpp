@@ -0,0 +1,337 @@
+#include "measure.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "membership_config.h"
+#include "node.h"
+#include "sender.h"
+#include "string_util.h"
+#include "table_print.h"
+#include "time_util.h"
+
+void TransitionLog::record(const std::string& subject, char from, char to) {
+    Transition t;
+    t.wall_ms = wall_ms();
+    t.subject = subject;
+    t.from = from;
+    t.to = to;
+
+    std::lock_guard<std::mutex> lk(mu_);
+    transitions_.push_back(std::move(t));
+    if (transitions_.size() > MEASURE_MAX_TRANSITIONS) transitions_.pop_front();
+}
+
+void TransitionLog::sample_bandwidth(uint64_t tx_bytes, uint64_t rx_bytes) {
+    std::lock_guard<std::mutex> lk(mu_);
+    bandwidth_.push_back({ wall_ms(), tx_bytes, rx_bytes });
+    if (bandwidth_.size() > MEASURE_MAX_BW_SAMPLES) bandwidth_.pop_front();
+}
+
+std::string TransitionLog::dump(const std::string& node_name, const std::string& node_ip) const {
+    // Our clock at dump time lets the collector estimate its offset.
+    std::string out = "N " + node_name + " " + node_ip + " " + std::to_string(wall_ms()) + "\n";
+
+    std::lock_guard<std::mutex> lk(mu_);
+    for (const auto& t : transitions_) {
+        out += "T " + std::to_string(t.wall_ms) + " " + t.subject + " ";
+        out.push_back(t.from);
+        out.push_back(t.to);
+        out.push_back('\n');
+    }
+    for (const auto& b : bandwidth_) {
+        out += "B " + std::to_string(b.wall_ms) + " " + std::to_string(b.tx_bytes)
+             + " " + std::to_string(b.rx_bytes) + "\n";
+    }
+    return out;
+}
+
+namespace {
+
+struct NodeLog {
+    std::string name;
+    std::string ip;
+    uint64_t dumped_ms = 0;      // its clock when it answered, 0 if unknown
+    int64_t offset_ms = 0;       // its clock minus ours
+    uint64_t offset_err_ms = 0;  // half the round trip
+    std::vector<Transition> transitions;
+    std::vector<BandwidthSample> bandwidth;
+};
+
+struct Experiment {
+    std::string subject;
+    bool stop = false;           // stop -> detection, otherwise start -> join
+    uint64_t t0 = 0;
+    uint64_t until = 0;          // next opposite event of the subject
+    std::vector<uint64_t> first; // per observer: first Suspect (stop) or Alive (start)
+    std::vector<uint64_t> dead;  // per observer: first Dead (stop only)
+    size_t observers = 0;
+    uint64_t window_end = 0;
+};
+
+}
+
+static bool parse_log(const std::string& text, NodeLog& log) {
+    std::istringstream in(text);
+    std::string line;
+
+    while (std::getline(in, line)) {
+        std::vector<std::string> f = split_ws(line);
+        if (f.empty()) continue;
+
+        try {
+            if (f[0] == "N" && f.size() >= 3) {
+                log.name = f[1];
+                log.ip = f[2];
+                if (f.size() >= 4) log.dumped_ms = std::stoull(f[3]);
+            } else if (f[0] == "T" && f.size() >= 4 && f[3].size() == 2) {
+                log.transitions.push_back({ std::stoull(f[1]), f[2], f[3][0], f[3][1] });
+            } else if (f[0] == "B" && f.size() >= 4) {
+                log.bandwidth.push_back({ std::stoull(f[1]), std::stoull(f[2]), std::stoull(f[3]) });
+            }
+        } catch (...) {
+            continue;
+        }
+    }
+    return !log.name.empty();
+}
+
+static uint64_t percentile(std::vector<uint64_t> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t idx = (size_t)(p * (double)(v.size() - 1) + 0.5);
+    return v[std::min(idx, v.size() - 1)];
+}
+
+static std::string fmt_ms(uint64_t v) {
+    if (v == std::numeric_limits<uint64_t>::max()) return "-";
+    return std::to_string(v);
+}
+
+// Bytes per second (tx + rx) between the samples bracketing [from, to].
+static double bandwidth_between(const NodeLog& log, uint64_t from, uint64_t to) {
+    const BandwidthSample* a = nullptr;
+    const BandwidthSample* b = nullptr;
+
+    for (const auto& s : log.bandwidth) {
+        if (s.wall_ms <= from) a = &s;
+        if (!b && s.wall_ms >= to) b = &s;
+    }
+    if (!a && !log.bandwidth.empty()) a = &log.bandwidth.front();
+    if (!b && !log.bandwidth.empty()) b = &log.bandwidth.back();
+    if (!a || !b || b->wall_ms <= a->wall_ms) return 0.0;
+
+    const double bytes = (double)(b->tx_bytes - a->tx_bytes) + (double)(b->rx_bytes - a->rx_bytes);
+    return bytes * 1000.0 / (double)(b->wall_ms - a->wall_ms);
+}
+
+// Moves a peer's timestamps onto our clock, assuming it answered halfway
+// through the round trip [sent_ms, got_ms].
+static void align_clock(NodeLog& log, uint64_t sent_ms, uint64_t got_ms) {
+    if (log.dumped_ms == 0) return;
+    log.offset_ms = (int64_t)log.dumped_ms - (int64_t)((sent_ms + got_ms) / 2);
+    log.offset_err_ms = (got_ms - sent_ms + 1) / 2;
+
+    for (auto& t : log.transitions) t.wall_ms = (uint64_t)((int64_t)t.wall_ms - log.offset_ms);
+    for (auto& b : log.bandwidth) b.wall_ms = (uint64_t)((int64_t)b.wall_ms - log.offset_ms);
+}
+
+static uint64_t first_own_start(const NodeLog& log) {
+    for (const auto& t : log.transitions)
+        if (t.subject == log.name && t.to == 'U') return t.wall_ms;
+    return 0;
+}
+
+void measure_report(Node& node) {
+    std::vector<std::pair<std::string, std::string>> peers;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        for (const auto& [name, info] : node.membership) {
+            if (name == node.name || info.ip.empty()) continue;
+            if (info.status != MemberStatus::Alive) continue;
+            peers.emplace_back(name, info.ip);
+        }
+    }
+
+    std::vector<NodeLog> logs;
+    {
+        NodeLog self;
+        if (parse_log(node.transitions.dump(node.name, node.ip), self))
+            logs.push_back(std::move(self));
+    }
+
+    for (const auto& [name, ip] : peers) {
+        std::string reply;
+        NodeLog log;
+        const uint64_t sent_ms = wall_ms();
+        if (request_tcp(ip, "MEASURE-DUMP\n", reply, 2000) && parse_log(reply, log)) {
+            align_clock(log, sent_ms, wall_ms());
+            logs.push_back(std::move(log));
+        } else {
+            std::cout << "No transition log from " << name << " (" << ip << ")\n";
+        }
+    }
+
+    std::vector<std::vector<std::string>> clock_rows;
+    for (const auto& log : logs) {
+        if (log.name == node.name) continue;
+        clock_rows.push_back({
+            log.name,
+            log.dumped_ms ? std::to_string(log.offset_ms) : "?",
+            log.dumped_ms ? std::to_string(log.offset_err_ms) : "?"
+        });
+    }
+    if (!clock_rows.empty()) {
+        std::cout << "Clock offsets from " << node.name
+            << " (ms, subtracted from each log; ERR is half the MEASURE-DUMP round trip):\n";
+        print_table({ "NODE", "OFFSET", "ERR" }, clock_rows);
+    }
+
+    std::cout << "Logs come from alive members only: a stopped node's experiments"
+        " show up once it has been started again.\n";
+
+    // Each node logs its own stop (X) and start (U); those anchor experiments.
+    std::vector<Experiment> exps;
+    for (const auto& log : logs) {
+        for (size_t i = 0; i < log.transitions.size(); i++) {
+            const Transition& t = log.transitions[i];
+            if (t.subject != log.name || (t.to != 'X' && t.to != 'U')) continue;
+
+            Experiment e;
+            e.subject = log.name;
+            e.stop = (t.to == 'X');
+            e.t0 = t.wall_ms;
+            e.until = std::numeric_limits<uint64_t>::max();
+
+            for (size_t j = i + 1; j < log.transitions.size(); j++) {
+                const Transition& n = log.transitions[j];
+                if (n.subject == log.name && (n.to == 'X' || n.to == 'U') && n.to != t.to) {
+                    e.until = n.wall_ms;
+                    break;
+                }
+            }
+            exps.push_back(std::move(e));
+        }
+    }
+
+    std::sort(exps.begin(), exps.end(), [](const Experiment& a, const Experiment& b) {
+        return a.t0 < b.t0;
+    });
+
+    std::vector<uint64_t> all_suspect, all_dead, all_alive;
+    std::vector<uint64_t> each_suspect, each_dead, each_alive;
+    std::map<std::string, std::vector<double>> bw_by_node;
+
+    std::vector<std::vector<std::string>> rows;
+
+    for (auto& e : exps) {
+        for (const auto& log : logs) {
+            if (log.name == e.subject) continue;
+
+            const uint64_t started = first_own_start(log);
+            if (started == 0 || started > e.t0) continue;
+            e.observers++;
+
+            uint64_t first = std::numeric_limits<uint64_t>::max();
+            uint64_t dead = std::numeric_limits<uint64_t>::max();
+
+            for (const auto& t : log.transitions) {
+                if (t.subject != e.subject) continue;
+                if (t.wall_ms < e.t0 || t.wall_ms >= e.until) continue;
+
+                if (e.stop) {
+                    if ((t.to == 'S' || t.to == 'D' || t.to == 'L') && first == std::numeric_limits<uint64_t>::max())
+                        first = t.wall_ms - e.t0;
+                    if ((t.to == 'D' || t.to == 'L') && dead == std::numeric_limits<uint64_t>::max())
+                        dead = t.wall_ms - e.t0;
+                } else if (t.to == 'A' && first == std::numeric_limits<uint64_t>::max()) {
+                    first = t.wall_ms - e.t0;
+                }
+            }
+
+            if (first != std::numeric_limits<uint64_t>::max()) e.first.push_back(first);
+            if (dead != std::numeric_limits<uint64_t>::max()) e.dead.push_back(dead);
+        }
+
+        const bool complete_first = e.observers > 0 && e.first.size() == e.observers;
+        const bool complete_dead = e.observers > 0 && e.dead.size() == e.observers;
+
+        const uint64_t none = std::numeric_limits<uint64_t>::max();
+        const uint64_t max_first = complete_first ? *std::max_element(e.first.begin(), e.first.end()) : none;
+        const uint64_t max_dead = complete_dead ? *std::max_element(e.dead.begin(), e.dead.end()) : none;
+
+        if (e.stop) {
+            each_suspect.insert(each_suspect.end(), e.first.begin(), e.first.end());
+            each_dead.insert(each_dead.end(), e.dead.begin(), e.dead.end());
+            if (complete_first) all_suspect.push_back(max_first);
+            if (complete_dead) all_dead.push_back(max_dead);
+        } else {
+            each_alive.insert(each_alive.end(), e.first.begin(), e.first.end());
+            if (complete_first) all_alive.push_back(max_first);
+        }
+
+        const uint64_t span = e.stop ? (complete_dead ? max_dead : 0) : (complete_first ? max_first : 0);
+        e.window_end = e.t0 + std::max<uint64_t>(span, 2 * TICK_MS);
+
+        for (const auto& log : logs) {
+            if (log.name == e.subject) continue;
+            bw_by_node[log.name].push_back(bandwidth_between(log, e.t0, e.window_end));
+        }
+
+        rows.push_back({
+            e.subject,
+            e.stop ? "stop" : "start",
+            std::to_string(e.t0),
+            std::to_string(e.first.size()) + "/" + std::to_string(e.observers),
+            fmt_ms(max_first),
+            e.stop ? fmt_ms(max_dead) : "-"
+        });
+    }
+
+    if (exps.empty()) {
+        std::cout << "No stop/start events in " << logs.size()
+            << " logs. Run 'stop' then 'start' on some node, then 'measure' again.\n";
+        return;
+    }
+
+    std::cout << "Experiments (" << logs.size() << " node logs, times in ms after the event):\n";
+    print_table({ "SUBJECT", "EVENT", "WALL_MS", "SEEN", "ALL_SUSPECT|ALIVE", "ALL_DEAD" }, rows);
+
+    auto pct_row = [](const std::string& label, const std::vector<uint64_t>& v) {
+        return std::vector<std::string>{
+            label, std::to_string(v.size()),
+            std::to_string(percentile(v, 0.50)),
+            std::to_string(percentile(v, 0.90)),
+            std::to_string(percentile(v, 0.99)),
+            std::to_string(v.empty() ? 0 : *std::max_element(v.begin(), v.end()))
+        };
+    };
+
+    std::cout << "Latency percentiles (ms):\n";
+    print_table({ "METRIC", "N", "P50", "P90", "P99", "MAX" }, {
+        pct_row("stop->suspect (per observer)", each_suspect),
+        pct_row("stop->dead (per observer)", each_dead),
+        pct_row("stop->suspect (all nodes)", all_suspect),
+        pct_row("stop->dead (all nodes)", all_dead),
+        pct_row("start->alive (per observer)", each_alive),
+        pct_row("start->alive (all nodes)", all_alive),
+    });
+
+    std::vector<std::vector<std::string>> bw_rows;
+    for (const auto& [name, v] : bw_by_node) {
+        double sum = 0, peak = 0;
+        for (double x : v) { sum += x; peak = std::max(peak, x); }
+        bw_rows.push_back({
+            name,
+            std::to_string((uint64_t)(v.empty() ? 0 : sum / (double)v.size())),
+            std::to_string((uint64_t)peak)
+        });
+    }
+
+    std::cout << "Bandwidth during experiments (bytes/s, tx+rx):\n";
+    print_table({ "NODE", "AVG", "PEAK" }, bw_rows);
+}
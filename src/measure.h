@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+class Node;
+
+inline constexpr size_t MEASURE_MAX_TRANSITIONS = 20000;
+inline constexpr size_t MEASURE_MAX_BW_SAMPLES  = 3600;
+
+// Transition states use the wire letters A/S/D, plus N (not known yet),
+// U (this node started) and X (this node stopped).
+struct Transition {
+    uint64_t wall_ms = 0;
+    std::string subject;
+    char from = 'N';
+    char to = 'N';
+};
+
+struct BandwidthSample {
+    uint64_t wall_ms = 0;
+    uint64_t tx_bytes = 0;
+    uint64_t rx_bytes = 0;
+};
+
+// Timestamped status transitions seen by this node, kept across stop/start
+// so `measure` can correlate them with other nodes' logs afterwards.
+class TransitionLog {
+public:
+    void record(const std::string& subject, char from, char to);
+    void sample_bandwidth(uint64_t tx_bytes, uint64_t rx_bytes);
+
+    // Text form served over TCP for MEASURE-DUMP.
+    std::string dump(const std::string& node_name, const std::string& node_ip) const;
+
+private:
+    mutable std::mutex mu_;
+    std::deque<Transition> transitions_;
+    std::deque<BandwidthSample> bandwidth_;
+};
+
+// Collects transition logs from every alive member over TCP and reports
+// detection and join latencies plus bandwidth per node. Each peer's times are
+// moved onto our clock using the offset estimated from the MEASURE-DUMP round
+// trip. A stopped node is not asked, so its stop only counts once it is back.
+void measure_report(Node& node);
@@ -0,0 +1,81 @@
+#include "member_id.h"
+
+#include <algorithm>
+
+#include "hash_util.h"
+
+static const char ID_ALPHABET[] =
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz-_";
+
+std::string member_id(const std::string& name, const std::string& ip) {
+    uint64_t h = mix64(fnv1a64(name) ^ mix64(fnv1a64(ip)));
+
+    std::string id(MEMBER_ID_CHARS, '0');
+    for (size_t i = 0; i < MEMBER_ID_CHARS; i++) {
+        id[i] = ID_ALPHABET[h & 63];
+        h >>= 6;
+    }
+    return id;
+}
+
+void MemberIds::update(const std::string& name, const std::string& ip) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+        if (it->second.first == ip) return;
+        remove(name);
+    }
+
+    const std::string id = member_id(name, ip);
+    ids_[name] = { ip, id };
+    names_[id].push_back(name);
+}
+
+void MemberIds::remove(const std::string& name) {
+    auto it = ids_.find(name);
+    if (it == ids_.end()) return;
+
+    auto n = names_.find(it->second.second);
+    if (n != names_.end()) {
+        auto& v = n->second;
+        v.erase(std::remove(v.begin(), v.end(), name), v.end());
+        if (v.empty()) names_.erase(n);
+    }
+    ids_.erase(it);
+}
+
+const std::string* MemberIds::resolve(const std::string& id) const {
+    auto it = names_.find(id);
+    if (it == names_.end() || it->second.size() != 1) return nullptr;
+    return &it->second.front();
+}
+
+const std::string& MemberIds::id_of(const std::string& name) const {
+    static const std::string none;
+    auto it = ids_.find(name);
+    if (it == ids_.end()) return none;
+
+    auto n = names_.find(it->second.second);
+    if (n == names_.end() || n->second.size() != 1) return none;
+    return it->second.second;
+}
+
+bool MemberIds::should_ask(const std::string& id, uint64_t now) {
+    if (asked_.size() > 1024) {
+        for (auto it = asked_.begin(); it != asked_.end(); ) {
+            if (now - it->second >= WHOIS_RETRY_MS) it = asked_.erase(it);
+            else ++it;
+        }
+    }
+
+    auto [it, inserted] = asked_.try_emplace(id, now);
+    if (inserted) return true;
+    if (now - it->second < WHOIS_RETRY_MS) return false;
+    it->second = now;
+    return true;
+}
+
+void MemberIds::clear() {
+    names_.clear();
+    ids_.clear();
+    asked_.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Compact member IDs. A member's ID is a 48-bit hash of its name and IP,
+// written as MEMBER_ID_CHARS base64url characters, so every node derives the
+// same ID from gossip it already has and no assignment round is needed.
+//
+// On the wire an ID is prefixed with '#': in the header (`TYPE #<id> <inc>
+// ...`), in piggyback entries (`#<id>@inc@S@lastSeen`) and in PING-REQ
+// targets. We only send IDs to a peer that has shown it knows ours (see
+// MemberInfo::id_ack); anyone meeting an ID it cannot resolve asks the sender
+// with `WHOIS <id>,<id>` and gets the full entries back in an IAM. IDs shared
+// by two members are never used; those members travel in full form.
+
+inline constexpr size_t   MEMBER_ID_CHARS = 8;
+inline constexpr uint64_t WHOIS_RETRY_MS  = 1000;
+inline constexpr size_t   WHOIS_MAX_IDS   = 32;     // answered per WHOIS
+
+std::string member_id(const std::string& name, const std::string& ip);
+
+// ID <-> name dictionary over the membership. Guarded by Node::membership_mu.
+class MemberIds {
+public:
+    void update(const std::string& name, const std::string& ip);
+    void remove(const std::string& name);
+
+    // The member named by `id`, or nullptr if unknown or ambiguous.
+    const std::string* resolve(const std::string& id) const;
+
+    // The wire ID of `name`, or "" if unknown or ambiguous.
+    const std::string& id_of(const std::string& name) const;
+
+    // True at most once per WHOIS_RETRY_MS for a given unknown ID.
+    bool should_ask(const std::string& id, uint64_t now);
+
+    size_t size() const { return ids_.size(); }
+    void clear();
+
+private:
+    std::unordered_map<std::string, std::vector<std::string>> names_;            // id -> names
+    std::unordered_map<std::string, std::pair<std::string, std::string>> ids_;   // name -> (ip, id)
+    std::unordered_map<std::string, uint64_t> asked_;
+};
@@ -0,0 +1,115 @@
+#include "membership.h"
+
+#include "hash_util.h"
+#include "membership_config.h"
+#include "trace.h"
+
+int status_rank(MemberStatus s) {
+    switch (s) {
+        case MemberStatus::Alive:   return 0;
+        case MemberStatus::Suspect: return 1;
+        case MemberStatus::Dead:    return 2;
+        case MemberStatus::Left:    return 3;
+        default:                    return 0;
+    }
+}
+
+char status_char(MemberStatus s) {
+    switch (s) {
+        case MemberStatus::Alive:   return 'A';
+        case MemberStatus::Suspect: return 'S';
+        case MemberStatus::Dead:    return 'D';
+        case MemberStatus::Left:    return 'L';
+        default:                    return 'A';
+    }
+}
+
+MemberStatus status_from_char(char c) {
+    if (c == 'A') return MemberStatus::Alive;
+    if (c == 'S') return MemberStatus::Suspect;
+    if (c == 'D') return MemberStatus::Dead;
+    if (c == 'L') return MemberStatus::Left;
+    return MemberStatus::Alive;
+}
+
+uint64_t member_key(const std::string& name, const MemberState& state) {
+    return mix64(fnv1a64(name) ^ mix64(state.incarnation * 4 + (uint64_t)status_rank(state.status)));
+}
+
+uint64_t member_key(const std::string& name, const MemberInfo& info) {
+    return member_key(name, state_of(info));
+}
+
+void merge_member(Node& node,
+                  const std::string& name,
+                  const std::string& ip,
+                  const std::string& inc_str,
+                  MemberStatus st,
+                  uint64_t now,
+                  bool direct) {
+    uint64_t inc = 0;
+    try { inc = (uint64_t)std::stoull(inc_str); } catch (...) { inc = 0; }
+
+    if (node.tombstones.size() && !node.membership.count(name)) {
+        if (!direct && node.tombstones.suppresses(name, inc)) return;
+        node.tombstones.erase(name);
+    }
+
+    auto [it, inserted] = node.membership.try_emplace(name);
+    MemberInfo& cur = it->second;
+    const MemberState before = inserted ? MemberState{} : state_of(cur);
+
+    if (!ip.empty()) cur.ip = ip;
+
+    if (direct) {
+        // Hearing from a member does not clear a suspicion at the same
+        // incarnation; the member has to refute it with a higher one. A
+        // delayed datagram with a lower one changes nothing.
+        cur.last_seen_ms = now;
+        if (inserted || inc > cur.incarnation ||
+            (inc == cur.incarnation && cur.status == MemberStatus::Alive)) {
+            cur.status = MemberStatus::Alive;
+            cur.incarnation = inc;
+        }
+    } else if (inserted || inc > cur.incarnation) {
+        cur.incarnation = inc;
+        cur.status = st;
+    } else if (inc == cur.incarnation && status_rank(st) > status_rank(cur.status)) {
+        cur.status = st;
+    }
+
+    if (cur.status == MemberStatus::Suspect && (inserted || before.status != MemberStatus::Suspect))
+        cur.suspect_since_ms = now;
+    if (is_gone(cur.status) && (inserted || before.status != cur.status))
+        cur.dead_since_ms = now;
+
+    if (inserted) {
+        trace_record(TraceKind::MergeNew, name, cur.incarnation, (uint64_t)status_rank(cur.status));
+    } else {
+        if (cur.incarnation != before.incarnation)
+            trace_record(TraceKind::MergeIncarnation, name, before.incarnation, cur.incarnation);
+        if (cur.status != before.status)
+            trace_record(TraceKind::MergeStatus, name, (uint64_t)status_rank(before.status), (uint64_t)status_rank(cur.status));
+    }
+
+    node.on_member_change(name, before, &cur);
+}
+
+void reclaim_dead_members(Node& node, uint64_t now) {
+    const uint64_t cutoff = now >= DEAD_RETAIN_MS ? now - DEAD_RETAIN_MS + 1 : 0;
+
+    for (const auto& name : node.schedule.dead().started_before(cutoff)) {
+        auto it = node.membership.find(name);
+        if (it == node.membership.end() || !is_gone(it->second.status)) continue;
+
+        // A member that left is not re-probed from its tombstone.
+        const MemberState before = state_of(it->second);
+        const bool left = it->second.status == MemberStatus::Left;
+        node.tombstones.add(name, it->second.incarnation, left ? std::string() : it->second.ip, now);
+
+        node.membership.erase(it);
+        node.on_member_change(name, before, nullptr);
+    }
+
+    node.tombstones.expire(now);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "node.h"
+
+int status_rank(MemberStatus s);
+
+// Dead or Left: out of the probe rounds, reclaimed after DEAD_RETAIN_MS.
+inline bool is_gone(MemberStatus s) {
+    return s == MemberStatus::Dead || s == MemberStatus::Left;
+}
+
+char status_char(MemberStatus s);
+MemberStatus status_from_char(char c);
+
+// Identity of (name, incarnation, status) used for view digests;
+// last_seen is local and excluded.
+uint64_t member_key(const std::string& name, const MemberInfo& info);
+uint64_t member_key(const std::string& name, const MemberState& state);
+
+// Merges one observation of `name` into node.membership. `direct` means the
+// member itself sent us a message; it revives a Suspect or Dead member only
+// at a new incarnation. `now` stamps last_seen and death times.
+// Gossip about a tombstoned member is ignored unless it carries a newer
+// incarnation. Caller must hold node.membership_mu.
+void merge_member(Node& node,
+                  const std::string& name,
+                  const std::string& ip,
+                  const std::string& inc_str,
+                  MemberStatus st,
+                  uint64_t now,
+                  bool direct);
+
+// Moves Dead and Left members older than DEAD_RETAIN_MS into node.tombstones and
+// expires old tombstones. Caller must hold node.membership_mu.
+void reclaim_dead_members(Node& node, uint64_t now);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 inline constexpr uint64_t TICK_MS    = 1000;
@@ -9,5 +10,85 @@ inline constexpr uint64_t SUSPECT_MS = 4000;
 inline constexpr size_t FANOUT = 3;
 inline constexpr size_t PIGGY_K = 3;
 
+// Datagrams stay within UDP_MAX_DATAGRAM, under the 2048-byte receive
+// buffer. Piggyback data gets PIGGY_MAX_BYTES of it, leaving room for the
+// message header; a trailer that does not fit waits for a later message.
+inline constexpr size_t UDP_MAX_DATAGRAM = 1900;
+inline constexpr size_t PIGGY_MAX_BYTES  = UDP_MAX_DATAGRAM - 256;
+
+// PING-REQ goes to the FANOUT helpers nearest the target among
+// PING_REQ_CANDIDATES random members of each probe round.
+inline constexpr size_t PING_REQ_CANDIDATES = 4 * FANOUT;
+
 inline constexpr uint64_t PING_TIMEOUT_MS     = 2000;
-inline constexpr uint64_t INDIRECT_TIMEOUT_MS = 2000;
\ No newline at end of file
+inline constexpr uint64_t INDIRECT_TIMEOUT_MS = 2000;
+
+// On stop a node sends LEAVE to LEAVE_FANOUT members; everyone who learns
+// of it pushes it on once, so the whole view marks it Left within a few
+// round trips instead of a probe timeout plus SUSPECT_MS.
+inline constexpr size_t LEAVE_FANOUT = 2 * FANOUT;
+
+// Dead members stay in the view (and in gossip) for DEAD_RETAIN_MS, then
+// shrink to tombstones that reject stale gossip until TOMBSTONE_MS passes.
+inline constexpr uint64_t DEAD_RETAIN_MS = 30000;
+inline constexpr uint64_t TOMBSTONE_MS   = 300000;
+inline constexpr size_t   MAX_TOMBSTONES = 10000;
+
+// Membership snapshot for warm restarts: rewritten at most every SNAPSHOT_MS
+// when the view changed, ignored on startup once older than the max age.
+inline constexpr uint64_t SNAPSHOT_MS         = 10000;
+inline constexpr uint64_t SNAPSHOT_MAX_AGE_MS = 600000;
+inline constexpr size_t   SNAPSHOT_JOINS      = 3;       // random snapshot peers sent a JOIN on warm start
+
+// Join storm control. Joiners back off exponentially with jitter; a node
+// answers a repeated JOIN from the same incarnation at most once per
+// JOIN_DEDUP_MS, reuses one WELCOME payload for JOIN_COALESCE_MS, and (on
+// seeds) redirects joiners to other members above JOIN_REDIRECT_RATE/s.
+// The dedup window ends before the earliest retry (JOIN_RETRY_MIN_MS / 2),
+// so a retry after a lost WELCOME is answered.
+inline constexpr uint64_t JOIN_RETRY_MIN_MS  = 750;
+inline constexpr uint64_t JOIN_RETRY_MAX_MS  = 30000;
+inline constexpr uint64_t JOIN_DEDUP_MS      = 250;
+static_assert(JOIN_DEDUP_MS < JOIN_RETRY_MIN_MS / 2, "a join retry must not fall in the dedup window");
+inline constexpr uint64_t JOIN_COALESCE_MS   = 200;
+inline constexpr uint64_t JOIN_REDIRECT_RATE = 100;
+inline constexpr size_t   JOIN_REDIRECT_K    = 3;
+
+// A changed entry is piggybacked ahead of random ones until it has been
+// sent DISSEMINATE_MULT * ceil(log2(N + 1)) times.
+inline constexpr size_t DISSEMINATE_MULT = 3;
+
+// One Dead or tombstoned member is pinged every REPROBE_MS (0 = never;
+// `reprobe` at runtime), so the two sides of a healed partition find each
+// other again even when all gossip between them says Dead.
+inline constexpr uint64_t REPROBE_MS = 2000;
+
+// Shared-memory membership table (shm_view.h): republished within
+// SHM_PUBLISH_MS of a view change, and every SHM_REFRESH_MS for last-seen.
+inline constexpr uint64_t SHM_PUBLISH_MS = 50;
+inline constexpr uint64_t SHM_REFRESH_MS = 1000;
+
+// Multicast discovery (discovery.conf). A node that is not joined announces
+// with the join backoff and starts a cluster of its own after
+// DISCOVERY_SOLO_MS without an answer. Members answer an unknown node with
+// probability DISCOVERY_RESPONDERS / alive and at most DISCOVERY_REPLY_RATE
+// times per second; the cluster as a whole re-announces about once per
+// DISCOVERY_ANNOUNCE_MS so separately started clusters merge.
+inline constexpr uint64_t DISCOVERY_SOLO_MS     = 5000;
+inline constexpr size_t   DISCOVERY_RESPONDERS  = 3;
+inline constexpr uint64_t DISCOVERY_REPLY_RATE  = 20;
+inline constexpr uint64_t DISCOVERY_ANNOUNCE_MS = 10000;
+
+// Zones (the "zone" metadata tag). Members probe their own zone every tick;
+// only the ZONE_REPRESENTATIVES alive members of each zone with the lowest
+// name hash probe across zones, one remote representative every
+// ZONE_REMOTE_EVERY ticks. Every ZONE_SAMPLE_EVERY ticks a representative
+// also probes some member of the next other zone in turn, in a round per
+// zone, so a zone that fails as a whole is not left to be found one
+// representative at a time. Each of its m members is then probed within
+// m * (zones - 1) * ZONE_SAMPLE_EVERY ticks by every live representative,
+// and detected a probe and SUSPECT_MS later; the representatives together
+// reach about ZONE_REPRESENTATIVES / ZONE_SAMPLE_EVERY of them per tick.
+inline constexpr size_t   ZONE_REPRESENTATIVES = 2;
+inline constexpr uint64_t ZONE_REMOTE_EVERY    = 2;
+inline constexpr uint64_t ZONE_SAMPLE_EVERY    = 2;
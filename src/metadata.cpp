@@ -0,0 +1,156 @@
+#include "metadata.h"
+
+#include <mutex>
+#include <random>
+
+#include "membership.h"
+#include "node.h"
+#include "string_util.h"
+
+std::string encode_meta(const std::string& name, uint64_t version, const Meta& meta) {
+    std::string out;
+    percent_encode(out, name);
+    out.push_back(':');
+    out += std::to_string(version);
+    out.push_back(':');
+
+    bool first = true;
+    for (const auto& [k, v] : meta) {
+        if (!first) out.push_back(';');
+        first = false;
+        percent_encode(out, k);
+        out.push_back('=');
+        percent_encode(out, v);
+    }
+    return out;
+}
+
+bool decode_meta(const std::string& s, std::string& name, uint64_t& version, Meta& meta) {
+    meta.clear();
+
+    const size_t c1 = s.find(':');
+    const size_t c2 = (c1 == std::string::npos) ? std::string::npos : s.find(':', c1 + 1);
+    if (c2 == std::string::npos) return false;
+
+    if (!percent_decode(s, 0, c1, name) || name.empty()) return false;
+    try { version = std::stoull(s.substr(c1 + 1, c2 - c1 - 1)); } catch (...) { return false; }
+
+    size_t start = c2 + 1;
+    while (start < s.size()) {
+        size_t semi = s.find(';', start);
+        if (semi == std::string::npos) semi = s.size();
+
+        const size_t eq = s.find('=', start);
+        if (eq == std::string::npos || eq > semi) return false;
+
+        std::string k, v;
+        if (!percent_decode(s, start, eq, k) || !percent_decode(s, eq + 1, semi, v) || k.empty()) return false;
+        meta[k] = v;
+        if (meta.size() > META_MAX_KEYS) return false;
+
+        start = semi + 1;
+    }
+    return true;
+}
+
+void MetaIndex::set(const std::string& name, const Meta& meta) {
+    remove(name);
+
+    std::vector<std::string>& tags = tags_of_[name];
+    for (const auto& [k, v] : meta) {
+        tags.push_back(k);
+        tags.push_back(k + "=" + v);
+    }
+    for (const auto& t : tags) by_tag_[t].insert(name);
+}
+
+void MetaIndex::remove(const std::string& name) {
+    auto it = tags_of_.find(name);
+    if (it == tags_of_.end()) return;
+
+    for (const auto& t : it->second) {
+        auto bt = by_tag_.find(t);
+        if (bt == by_tag_.end()) continue;
+        bt->second.erase(name);
+        if (bt->second.empty()) by_tag_.erase(bt);
+    }
+    tags_of_.erase(it);
+}
+
+const std::set<std::string>* MetaIndex::find(const std::string& key, const std::string* value) const {
+    auto it = by_tag_.find(value ? key + "=" + *value : key);
+    return it == by_tag_.end() ? nullptr : &it->second;
+}
+
+void MetaIndex::clear() {
+    by_tag_.clear();
+    tags_of_.clear();
+}
+
+void merge_meta(Node& node, const std::string& name, uint64_t version, Meta meta) {
+    if (name == node.name) return;
+
+    auto it = node.membership.find(name);
+    if (it == node.membership.end()) return;
+
+    MemberInfo& info = it->second;
+    if (version <= info.meta_version) return;
+
+    const bool changed = info.meta != meta;
+    info.meta = std::move(meta);
+    info.meta_version = version;
+    node.meta_index.set(name, info.meta);
+    node.meta_updates.enqueue(name);
+
+    if (!changed) return;
+    node.schedule.update(name, &info);
+    node.events.publish(MemberEventKind::Meta, name, info.ip, info.incarnation, status_char(info.status));
+}
+
+std::string meta_field(Node& node, size_t max_bytes) {
+    std::string name;
+
+    std::vector<std::string> queued = node.meta_updates.take(1, retransmit_limit(node.membership.size()));
+    if (!queued.empty()) {
+        name = queued.front();
+    } else {
+        // Anti-entropy: a random member's map (ourselves included), so late
+        // joiners catch up. A few draws, not a scan: this runs for every
+        // outgoing message.
+        static thread_local std::mt19937 rng(std::random_device{}());
+        const ProbeRound& known = node.schedule.known();
+        std::uniform_int_distribution<size_t> pick(0, known.size());
+
+        for (size_t tries = 0; tries < META_ANTI_ENTROPY_TRIES && name.empty(); tries++) {
+            std::vector<std::string> one;
+            if (pick(rng) == known.size()) one.push_back(node.name);
+            else known.sample(1, rng, one);
+            if (one.empty()) continue;
+
+            auto it = node.membership.find(one.front());
+            if (it != node.membership.end() && it->second.meta_version != 0) name = one.front();
+        }
+    }
+
+    auto it = node.membership.find(name);
+    if (name.empty() || it == node.membership.end() || it->second.meta_version == 0) return "";
+
+    std::string enc = encode_meta(name, it->second.meta_version, it->second.meta);
+    if (enc.size() > META_MAX_BYTES || enc.size() + 2 > max_bytes) return "";
+    return "M=" + enc;
+}
+
+std::vector<std::string> members_with_tag(Node& node, const std::string& key, const std::string* value) {
+    std::vector<std::string> out;
+
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+    const std::set<std::string>* names = node.meta_index.find(key, value);
+    if (!names) return out;
+
+    for (const auto& n : *names) {
+        auto it = node.membership.find(n);
+        if (it != node.membership.end() && it->second.status == MemberStatus::Alive)
+            out.push_back(n);
+    }
+    return out;
+}
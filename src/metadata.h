@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Node;
+
+// Per-member key/value metadata (role, zone, build, load, ...). Only the
+// owner changes its map, bumping the version; everyone else keeps the
+// highest version seen (last writer wins). Maps travel as one trailer field
+// per piggyback:
+//
+//   M=<name>:<version>:<key>=<value>;<key>=<value>
+//
+// with names, keys and values percent-escaped.
+
+inline constexpr size_t META_MAX_KEYS           = 16;
+inline constexpr size_t META_MAX_BYTES          = 512;  // encoded field
+inline constexpr size_t META_ANTI_ENTROPY_TRIES = 4;    // random members tried when nothing is queued
+
+using Meta = std::map<std::string, std::string>;
+
+std::string encode_meta(const std::string& name, uint64_t version, const Meta& meta);
+bool decode_meta(const std::string& s, std::string& name, uint64_t& version, Meta& meta);
+
+// Reverse index from "key" and "key=value" to member names, so tag queries
+// cost O(matches). Guarded by Node::membership_mu.
+class MetaIndex {
+public:
+    void set(const std::string& name, const Meta& meta);
+    void remove(const std::string& name);
+    const std::set<std::string>* find(const std::string& key, const std::string* value) const;
+    void clear();
+
+private:
+    std::unordered_map<std::string, std::set<std::string>> by_tag_;
+    std::unordered_map<std::string, std::vector<std::string>> tags_of_;
+};
+
+// Adopts `meta` for `name` if `version` is newer than what we hold. Caller
+// must hold node.membership_mu.
+void merge_meta(Node& node, const std::string& name, uint64_t version, Meta meta);
+
+// The M= field for the next piggyback, or "" if nobody has metadata or it
+// would exceed `max_bytes`. Caller must hold node.membership_mu.
+std::string meta_field(Node& node, size_t max_bytes);
+
+// Alive members whose map has `key` (and `value`, if given). Locks
+// membership_mu.
+std::vector<std::string> members_with_tag(Node& node, const std::string& key, const std::string* value);
@@ -5,17 +5,24 @@
 #include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <string>
 
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "faults.h"
 #include "join.h"
+#include "log.h"
+#include "membership.h"
+#include "membership_config.h"
 #include "net_util.h"
+#include "piggyback.h"
 #include "receiver.h"
 #include "sender.h"
 #include "time_util.h"
+#include "trace.h"
 
 static uint64_t read_or_init_incarnation(const std::string& path) {
     std::ifstream in(path);
@@ -29,14 +36,11 @@ static uint64_t read_or_init_incarnation(const std::string& path) {
     return 0;
 }
 
-static void write_incarnation(const std::string& path, uint64_t inc) {
-    std::ofstream out(path, std::ios::trunc);
-    if (out) out << inc << "\n";
-}
-
 Node::Node(std::vector<std::string> s) : seeds(std::move(s)) {
     name = get_hostname();
     ip = detect_local_ip();
+    id = member_id(name, ip);
+    schedule.set_self(name);
 
     if(std::find(seeds.begin(), seeds.end(), ip) != seeds.end()) {
         is_seed = true;
@@ -49,36 +53,79 @@ Node::~Node() {
     stop();
 }
 
+// Drops the view and everything derived from it.
+static void clear_view(Node& node) {
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+    node.membership.clear();
+    node.tombstones.clear();
+    node.dissemination.clear();
+    node.meta_updates.clear();
+    node.meta_index.clear();
+    node.ring.clear();
+    node.ids.clear();
+    node.schedule.clear();
+    node.view_digest.store(0);
+    node.view_iblt = Iblt();
+}
+
 bool Node::start() {
+    std::lock_guard<std::mutex> life(lifecycle_mu);
     if (running.load()) return true;
 
-    incarnation = read_or_init_incarnation("incarnation");
+    incarnation = read_or_init_incarnation(INCARNATION_PATH);
     set_incarnation(incarnation + 1);
 
+    events.start();
+    std::vector<std::string> known_peers = load_snapshot(*this, SNAPSHOT_PATH, SNAPSHOT_MAX_AGE_MS);
+
     udp_sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (udp_sock < 0) {
-        perror("udp socket");
+        log_errno("udp socket");
+        clear_view(*this);
+        events.stop();
         return false;
     }
 
     tcp_sock = socket(AF_INET, SOCK_STREAM, 0);
     if (tcp_sock < 0) {
-        perror("tcp socket");
+        log_errno("tcp socket");
         close(udp_sock);
         udp_sock = -1;
+        clear_view(*this);
+        events.stop();
         return false;
     }
 
+    leaving.store(false);
     running.store(true);
     attempt_join.store(true);
     joined.store(false);
 
     udpq.start(*this);
     hb.start(*this);
+    persist.start(*this);
 
     udp_thread = std::thread(udp_receiver_loop, udp_sock, std::ref(*this));
     tcp_thread = std::thread(tcp_receiver_loop, tcp_sock, std::ref(*this));
 
+    // Warm start: the snapshot members are already in the view and get
+    // probed in the normal rounds. A JOIN to a few random ones, in parallel
+    // with the seeds, gets WELCOMEs whose digests start a reconcile; while
+    // the snapshot is recent the difference is small enough to settle in a
+    // round trip, and gossip fills in the rest.
+    known_peers.erase(std::remove(known_peers.begin(), known_peers.end(), ip), known_peers.end());
+    if (!known_peers.empty()) {
+        std::cout << "Warm start: " << known_peers.size() << " members from snapshot.\n";
+
+        std::mt19937 rng(std::random_device{}());
+        std::shuffle(known_peers.begin(), known_peers.end(), rng);
+        if (known_peers.size() > SNAPSHOT_JOINS) known_peers.resize(SNAPSHOT_JOINS);
+
+        const std::string msg = make_msg("JOIN", *this);
+        for (const auto& peer_ip : known_peers)
+            send_udp(peer_ip, msg);
+    }
+
     if (is_seed) {
         std::cout << "Seed node: syncing with other seeds (best-effort).\n";
         attempt_join.store(false);
@@ -103,17 +150,77 @@ bool Node::start() {
     me.status = MemberStatus::Alive;
     me.last_seen_ms = now_ms();
     me.incarnation = incarnation;
+    me.has_coord = true;
 
     {
         std::lock_guard<std::mutex> lk(membership_mu);
-        membership[name] = me;
+        auto it = membership.find(name);
+        const MemberState before = (it != membership.end()) ? state_of(it->second) : MemberState{};
+
+        if (!own_meta_.empty()) {
+            me.meta = own_meta_;
+            me.meta_version = (incarnation.load() << 32) | ++meta_seq_;
+        }
+
+        MemberInfo& self = membership[name];
+        self = me;
+        on_member_change(name, before, &self);
+        if (self.meta_version) {
+            meta_index.set(name, self.meta);
+            meta_updates.enqueue(name);
+        }
+        transitions.record(name, 'X', 'U');
     }
 
+    shm.start(*this);
+    discovery.start(*this);
+
     std::cout << "Node [" << name << "@" << ip << "] started.\n";
     return true;
 }
 
+// Tells LEAVE_FANOUT alive members that we leave at our current
+// incarnation. Best effort: whoever misses it still detects us by probing.
+static void announce_leave(Node& node) {
+    static thread_local std::mt19937 rng(std::random_device{}());
+
+    std::string msg;
+    std::vector<std::string> targets;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        auto self = node.membership.find(node.name);
+        if (self == node.membership.end()) return;
+
+        MemberInfo left = self->second;
+        left.status = MemberStatus::Left;
+        msg = make_msg("LEAVE", node, make_entry(node.name, left));
+
+        std::vector<std::string> sample;
+        node.schedule.known().sample(2 * LEAVE_FANOUT, rng, sample);
+        for (const auto& name : sample) {
+            if (targets.size() == LEAVE_FANOUT) break;
+            auto it = node.membership.find(name);
+            if (it != node.membership.end() && it->second.status == MemberStatus::Alive)
+                targets.push_back(it->second.ip);
+        }
+    }
+
+    for (const auto& ip : targets) send_udp(ip, msg);
+    log_info("left the cluster: told %zu members", targets.size());
+}
+
 void Node::stop() {
+    std::lock_guard<std::mutex> life(lifecycle_mu);
+    if (!running.load()) return;
+
+    // Marked before LEAVE goes out: measure times the peers' reactions
+    // from here.
+    transitions.record(name, 'U', 'X');
+
+    // Peers echo our Left entry back while the receiver still runs; it
+    // must not be refuted.
+    leaving.store(true);
+    if (joined.load()) announce_leave(*this);
     if (!running.exchange(false)) return;
 
     attempt_join.store(false);
@@ -126,29 +233,153 @@ void Node::stop() {
     if (udp_sock >= 0) close(udp_sock);
     if (tcp_sock >= 0) close(tcp_sock);
 
+    discovery.stop();
     udpq.stop();
     hb.stop();
+    persist.stop();
+    shm.stop();
+    events.stop();
 
     if (udp_thread.joinable()) udp_thread.join();
     if (tcp_thread.joinable()) tcp_thread.join();
     if (join_thread.joinable()) join_thread.join();
+    fault_drop_pending();
 
     udp_sock = -1;
     tcp_sock = -1;
 
+    clear_view(*this);
+
+    reconcile.reset();
+    join_gate.reset();
+    broadcasts.reset();
     {
-        std::lock_guard<std::mutex> lk(membership_mu);
-        membership.clear();
+        std::lock_guard<std::mutex> lk(join_hints_mu);
+        join_hints.clear();
     }
 
     std::cout << "Node [" << name << "@" << ip << "] stopped.\n";
 }
 
 uint64_t Node::set_incarnation(uint64_t new_inc) {
+    trace_record(TraceKind::Incarnation, name, incarnation, new_inc);
+    incarnation = new_inc;
+    write_incarnation_file(new_inc);
+
+    return new_inc;
+}
+
+void Node::refute(uint64_t claimed_inc, MemberStatus claimed) {
+    const uint64_t old_inc = incarnation.load();
+    if (claimed_inc < old_inc || leaving.load()) return;
+    // Our own LEAVE coming back: only a restart starts a new incarnation.
+    if (claimed == MemberStatus::Left && claimed_inc == old_inc) return;
+
+    const uint64_t new_inc = claimed_inc + 1;
+    trace_record(TraceKind::Refute, name, claimed_inc, (uint64_t)claimed);
+    trace_record(TraceKind::Incarnation, name, old_inc, new_inc);
+
     incarnation = new_inc;
-    write_incarnation("incarnation", incarnation);
+    persist.save_incarnation(new_inc);
+
+    auto it = membership.find(name);
+    if (it != membership.end()) {
+        const MemberState before = state_of(it->second);
+        it->second.incarnation = new_inc;
+        it->second.status = MemberStatus::Alive;
+        on_member_change(name, before, &it->second);
+    }
+
+    dissemination.request_push(name);
+    refutations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Node::on_member_change(const std::string& member, const MemberState& before, const MemberInfo* after) {
+    uint64_t digest = view_digest.load(std::memory_order_relaxed);
+    if (before.known) {
+        const uint64_t key = member_key(member, before);
+        digest ^= key;
+        view_iblt.erase(key);
+    }
+    if (after) {
+        const uint64_t key = member_key(member, *after);
+        digest ^= key;
+        view_iblt.insert(key);
+    }
+    view_digest.store(digest, std::memory_order_relaxed);
+
+    if (after && after->status == MemberStatus::Alive) ring.add(member);
+    else ring.remove(member);
+    schedule.update(member, after);
+
+    if (!after) {
+        events.publish(MemberEventKind::Removed, member, "", before.incarnation, status_char(before.status));
+        ids.remove(member);
+        dissemination.erase(member);
+        meta_updates.erase(member);
+        meta_index.remove(member);
+        return;
+    }
+
+    if (!after->ip.empty()) ids.update(member, after->ip);
+
+    if (!before.known || before.incarnation != after->incarnation || before.status != after->status)
+        dissemination.enqueue(member);
+
+    // A departure is pushed on as soon as we hear of it.
+    if (after->status == MemberStatus::Left && (!before.known || before.status != MemberStatus::Left))
+        dissemination.request_push(member);
+
+    if (before.known && before.status == after->status) return;
+
+    const MemberEventKind kind =
+        !before.known                            ? MemberEventKind::Joined :
+        after->status == MemberStatus::Suspect   ? MemberEventKind::Suspect :
+        after->status == MemberStatus::Dead      ? MemberEventKind::Dead :
+        after->status == MemberStatus::Left      ? MemberEventKind::Left :
+                                                   MemberEventKind::Alive;
+    events.publish(kind, member, after->ip, after->incarnation, status_char(after->status));
+
+    transitions.record(member,
+                       before.known ? status_char(before.status) : 'N',
+                       status_char(after->status));
+}
+
+static bool set_own_meta(Node& node, Meta next) {
+    if (next.size() > META_MAX_KEYS) return false;
+    if (encode_meta(node.name, UINT64_MAX, next).size() + 2 > META_MAX_BYTES) return false;
+
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+    node.own_meta_ = std::move(next);
+
+    auto it = node.membership.find(node.name);
+    if (it == node.membership.end()) return true;
+
+    it->second.meta = node.own_meta_;
+    it->second.meta_version = (node.incarnation.load() << 32) | ++node.meta_seq_;
+    node.meta_index.set(node.name, it->second.meta);
+    node.schedule.update(node.name, &it->second);
+    node.meta_updates.enqueue(node.name);
+    node.events.publish(MemberEventKind::Meta, node.name, it->second.ip, it->second.incarnation, 'A');
+    return true;
+}
+
+bool Node::set_meta(const std::string& key, const std::string& value) {
+    if (key.empty()) return false;
+    Meta next = own_meta();
+    next[key] = value;
+    return set_own_meta(*this, std::move(next));
+}
+
+bool Node::erase_meta(const std::string& key) {
+    Meta next = own_meta();
+    if (!next.erase(key)) return false;
+    return set_own_meta(*this, std::move(next));
+}
 
-    return incarnation;
+Meta Node::own_meta() const {
+    std::lock_guard<std::mutex> lk(membership_mu);
+    return own_meta_;
 }
 
 bool Node::ping_test(std::string arg) {
@@ -9,12 +9,28 @@
 #include <mutex>
 
 #include "udp_queue.h"
+#include "broadcast.h"
+#include "discovery.h"
+#include "dissemination.h"
+#include "events.h"
 #include "heartbeat.h"
+#include "join.h"
+#include "measure.h"
+#include "member_id.h"
+#include "metadata.h"
+#include "persist.h"
+#include "probe_schedule.h"
+#include "reconcile.h"
+#include "ring.h"
+#include "shm_publish.h"
+#include "tombstones.h"
+#include "vivaldi.h"
 
 enum class MemberStatus {
     Alive,
     Suspect,
-    Dead
+    Dead,
+    Left        // announced its own departure
 };
 
 struct MemberInfo {
@@ -26,15 +42,48 @@ struct MemberInfo {
     uint64_t incarnation = 0;
 
     uint64_t suspect_since_ms = 0;
+    uint64_t dead_since_ms = 0;     // or since it left
+
+    Meta meta;
+    uint64_t meta_version = 0;
+
+    // Last coordinate the member sent us (ours, for the self entry).
+    Coord coord;
+    bool has_coord = false;
+
+    // The member acknowledged our ID while at id_ack_inc, so it can be sent
+    // compact headers and entries.
+    bool id_ack = false;
+    uint64_t id_ack_inc = 0;
+};
+
+// A member's state before a change; `known` is false for new members.
+struct MemberState {
+    bool known = false;
+    MemberStatus status = MemberStatus::Alive;
+    uint64_t incarnation = 0;
 };
 
+inline MemberState state_of(const MemberInfo& m) {
+    return { true, m.status, m.incarnation };
+}
+
+// Whether messages to this member may use compact IDs; a restart (new
+// incarnation) needs a fresh acknowledgement.
+inline bool speaks_ids(const MemberInfo& m) {
+    return m.id_ack && m.id_ack_inc == m.incarnation;
+}
+
 
 class Node {
 public:
     std::string name;
     std::string ip;
+    std::string id;         // member_id(name, ip)
 
-    uint64_t incarnation = 0;
+    std::atomic<uint64_t> incarnation{0};
+
+    std::atomic<uint64_t> refutations{0};
 
     std::vector<std::string> seeds;
     bool is_seed;
@@ -42,19 +91,50 @@ public:
     std::atomic<bool> running{false};
     std::atomic<bool> attempt_join{false};
     std::atomic<bool> joined{false};
+    std::atomic<bool> leaving{false};   // from LEAVE until stop() finishes
+    std::mutex lifecycle_mu;            // serializes start() and stop()
 
     int udp_sock{-1};
     int tcp_sock{-1};
 
     UdpQueue udpq;
     Heartbeat hb;
+    Persister persist;
+    ShmPublisher shm;
+    Discovery discovery;
 
     std::thread udp_thread;
     std::thread tcp_thread;
     std::thread join_thread;
 
+    // Members a seed redirected us to; consumed by the join thread.
+    std::mutex join_hints_mu;
+    std::vector<std::string> join_hints;
+    JoinGate join_gate;
+
     mutable std::mutex membership_mu;
     std::map<std::string, MemberInfo> membership;
+    Tombstones tombstones;
+    Dissemination dissemination;
+    Dissemination meta_updates;
+    MetaIndex meta_index;
+    Broadcaster broadcasts;
+    HashRing ring;
+    MemberIds ids;
+    ProbeSchedule schedule;
+
+    // XOR of member_key() over membership, and the same keys as an IBLT so
+    // a SYNC need not rebuild it; updated under membership_mu.
+    std::atomic<uint64_t> view_digest{0};
+    Iblt view_iblt;
+    Reconciler reconcile;
+
+    TransitionLog transitions;
+    EventBus events;
+    std::atomic<uint64_t> rx_bytes{0};
+
+    Meta own_meta_;         // guarded by membership_mu
+    uint32_t meta_seq_ = 0;
 
     std::mutex cli_ping_mu_;
     std::condition_variable cli_ping_cv_;
@@ -68,5 +148,19 @@ public:
 
     uint64_t set_incarnation(uint64_t new_inc);
 
+    // Gossip claims we are Suspect or Dead at `claimed_inc`: move past it
+    // and spread the new incarnation. Caller must hold membership_mu.
+    void refute(uint64_t claimed_inc, MemberStatus claimed);
+
+    // Called with membership_mu held after `name` changed; `after` is
+    // nullptr when the entry was removed.
+    void on_member_change(const std::string& name, const MemberState& before, const MemberInfo* after);
+
+    // Changes this node's own metadata; false if it would exceed the
+    // META_MAX_* limits. Kept across stop/start.
+    bool set_meta(const std::string& key, const std::string& value);
+    bool erase_meta(const std::string& key);
+    Meta own_meta() const;
+
     bool ping_test(std::string arg);
 };
@@ -0,0 +1,204 @@
+#include "persist.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "membership.h"
+#include "membership_config.h"
+#include "node.h"
+#include "string_util.h"
+#include "time_util.h"
+
+// Snapshot format:
+//   GDS-SNAPSHOT 1 <wall_ms> <self name>
+//   <name> <ip> <incarnation> <A|S|D>
+// one member per line.
+
+struct SnapshotRow {
+    std::string name;
+    std::string ip;
+    uint64_t incarnation = 0;
+    char status = 'A';
+};
+
+static bool write_file_atomic(const std::string& path, const std::string& data) {
+    const std::string tmp = path + ".tmp";
+
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { log_errno("snapshot open"); return false; }
+
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = write(fd, data.data() + off, data.size() - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log_errno("snapshot write");
+            close(fd);
+            return false;
+        }
+        off += (size_t)n;
+    }
+
+    if (fsync(fd) < 0) log_errno("snapshot fsync");
+    close(fd);
+
+    if (rename(tmp.c_str(), path.c_str()) < 0) {
+        log_errno("snapshot rename");
+        return false;
+    }
+
+    // The rename itself is only durable once the directory is synced.
+    const size_t slash = path.rfind('/');
+    const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int dfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dfd < 0) { log_errno("snapshot dir open"); return true; }
+    if (fsync(dfd) < 0) log_errno("snapshot dir fsync");
+    close(dfd);
+    return true;
+}
+
+bool write_incarnation_file(uint64_t inc) {
+    return write_file_atomic(INCARNATION_PATH, std::to_string(inc) + "\n");
+}
+
+bool write_snapshot(Node& node, const std::string& path) {
+    std::vector<SnapshotRow> rows;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        rows.reserve(node.membership.size());
+        for (const auto& [name, info] : node.membership) {
+            if (name == node.name || info.ip.empty()) continue;
+            rows.push_back({ name, info.ip, info.incarnation, status_char(info.status) });
+        }
+    }
+
+    std::string out = "GDS-SNAPSHOT 1 " + std::to_string(wall_ms()) + " " + node.name + "\n";
+    for (const auto& r : rows) {
+        out += r.name;
+        out.push_back(' ');
+        out += r.ip;
+        out.push_back(' ');
+        out += std::to_string(r.incarnation);
+        out.push_back(' ');
+        out.push_back(r.status);
+        out.push_back('\n');
+    }
+
+    return write_file_atomic(path, out);
+}
+
+std::vector<std::string> load_snapshot(Node& node, const std::string& path, uint64_t max_age_ms) {
+    std::vector<std::string> peers;
+
+    std::ifstream in(path);
+    if (!in) return peers;
+
+    std::string line;
+    if (!std::getline(in, line)) return peers;
+
+    std::vector<std::string> head = split_ws(line);
+    if (head.size() < 4 || head[0] != "GDS-SNAPSHOT" || head[1] != "1") return peers;
+
+    uint64_t written = 0;
+    try { written = std::stoull(head[2]); } catch (...) { return peers; }
+
+    const uint64_t wall = wall_ms();
+    if (written > wall || wall - written > max_age_ms) return peers;
+
+    const uint64_t now = now_ms();
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+
+    while (std::getline(in, line)) {
+        std::vector<std::string> f = split_ws(line);
+        if (f.size() < 4 || f[3].size() != 1) continue;
+        if (f[0] == node.name) continue;
+
+        const MemberStatus st = status_from_char(f[3][0]);
+        if (is_gone(st)) continue;
+
+        merge_member(node, f[0], f[1], f[2], st, now, false);
+        peers.push_back(f[1]);
+    }
+
+    return peers;
+}
+
+void Persister::start(Node& node) {
+    if (th_.joinable()) return;
+    node_ = &node;
+    running_ = true;
+    written_digest_ = 0;
+    th_ = std::thread(&Persister::loop, this);
+}
+
+void Persister::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (th_.joinable()) th_.join();
+
+    if (inc_pending_) {
+        write_incarnation_file(pending_inc_);
+        inc_pending_ = false;
+    }
+
+    // Final snapshot while the view is still populated.
+    if (node_) write_snapshot(*node_, SNAPSHOT_PATH);
+    node_ = nullptr;
+}
+
+void Persister::save_incarnation(uint64_t inc) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!running_) {
+        lk.unlock();
+        write_incarnation_file(inc);
+        return;
+    }
+
+    pending_inc_ = inc;
+    inc_pending_ = true;
+    lk.unlock();
+    cv_.notify_all();
+}
+
+void Persister::loop() {
+    using clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lk(mu_);
+    auto next_snapshot = clock::now() + std::chrono::milliseconds(SNAPSHOT_MS);
+
+    while (running_) {
+        cv_.wait_until(lk, next_snapshot, [&]{ return !running_ || inc_pending_; });
+        if (!running_) break;
+
+        if (inc_pending_) {
+            const uint64_t inc = pending_inc_;
+            inc_pending_ = false;
+
+            lk.unlock();
+            write_incarnation_file(inc);
+            lk.lock();
+            continue;
+        }
+
+        next_snapshot = clock::now() + std::chrono::milliseconds(SNAPSHOT_MS);
+
+        const uint64_t digest = node_->view_digest.load();
+        if (digest == written_digest_) continue;
+
+        lk.unlock();
+        const bool ok = write_snapshot(*node_, SNAPSHOT_PATH);
+        lk.lock();
+
+        if (ok) written_digest_ = digest;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Node;
+
+inline const char* const SNAPSHOT_PATH    = "membership.snapshot";
+inline const char* const INCARNATION_PATH = "incarnation";
+
+// Background writer for the membership snapshot and the incarnation file.
+// The view is copied under membership_mu; formatting and file I/O happen on
+// this thread.
+class Persister {
+public:
+    void start(Node& node);
+    void stop();
+
+    // Queues an incarnation write without blocking; falls back to a
+    // synchronous write when the thread is not running.
+    void save_incarnation(uint64_t inc);
+
+private:
+    void loop();
+
+    Node* node_ = nullptr;
+    std::thread th_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    uint64_t written_digest_ = 0;
+
+    bool inc_pending_ = false;
+    uint64_t pending_inc_ = 0;
+};
+
+bool write_incarnation_file(uint64_t inc);
+
+// Writes `path` crash-safely (temp file, fsync, rename).
+bool write_snapshot(Node& node, const std::string& path);
+
+// Merges a snapshot no older than max_age_ms into the view and returns the
+// IPs of the members it listed as Alive or Suspect.
+std::vector<std::string> load_snapshot(Node& node, const std::string& path, uint64_t max_age_ms);
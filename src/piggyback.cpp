@@ -0,0 +1,199 @@
+#include "piggyback.h"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "hash_util.h"
+#include "membership.h"
+#include "string_util.h"
+#include "time_util.h"
+
+// name@ip@inc@S@lastSeen, or #id@inc@S@lastSeen
+std::string make_entry(const std::string& name, const MemberInfo& info, const std::string& id) {
+    std::string e;
+    e.reserve(name.size() + info.ip.size() + 32);
+    if (!id.empty()) {
+        e.push_back('#');
+        e += id;
+    } else {
+        e += name;
+        e.push_back('@');
+        e += info.ip;
+    }
+    e.push_back('@');
+    e += std::to_string(info.incarnation);
+    e.push_back('@');
+    e.push_back(status_char(info.status));
+    e.push_back('@');
+    e += std::to_string(info.last_seen_ms);
+    return e;
+}
+
+// Samples k members from node.schedule, O(k) whatever the view size.
+static std::string piggyback_csv_random_k(const Node& node,
+                                         const std::string& exclude_name,
+                                         size_t k,
+                                         bool compact) {
+    if (k == 0) return "";
+
+    static thread_local std::mt19937 rng(std::random_device{}());
+
+    // One extra in case the sample holds the recipient.
+    std::vector<std::string> sample;
+    node.schedule.known().sample(k + 1, rng, sample);
+
+    std::string out;
+    size_t picked = 0;
+    for (const auto& name : sample) {
+        if (picked == k) break;
+        if (name == exclude_name) continue;
+
+        auto it = node.membership.find(name);
+        if (it == node.membership.end()) continue;
+
+        if (picked++) out.push_back(',');
+        out += make_entry(name, it->second, compact ? node.ids.id_of(name) : std::string());
+    }
+    return out;
+}
+
+void apply_piggyback(Node& node, const std::string& csv, std::vector<std::string>* unknown) {
+    if (csv.empty()) return;
+
+    const uint64_t now = now_ms();
+
+    size_t start = 0;
+    while (start < csv.size()) {
+        size_t comma = csv.find(',', start);
+        if (comma == std::string::npos) comma = csv.size();
+
+        std::string entry = csv.substr(start, comma - start);
+        start = comma + 1;
+
+        // A compact entry is the full one with `name@ip` replaced by `#id`.
+        if (!entry.empty() && entry[0] == '#') {
+            const size_t at = entry.find('@');
+            if (at == std::string::npos) continue;
+
+            const std::string id = entry.substr(1, at - 1);
+            const std::string* name = node.ids.resolve(id);
+            if (!name) {
+                if (unknown && id.size() == MEMBER_ID_CHARS) unknown->push_back(id);
+                continue;
+            }
+            auto it = node.membership.find(*name);
+            if (it == node.membership.end()) continue;
+            entry = *name + "@" + it->second.ip + entry.substr(at);
+        }
+
+        size_t a = entry.find('@');
+        size_t b = (a == std::string::npos) ? std::string::npos : entry.find('@', a + 1);
+        size_t c = (b == std::string::npos) ? std::string::npos : entry.find('@', b + 1);
+        size_t d = (c == std::string::npos) ? std::string::npos : entry.find('@', c + 1);
+
+        if (a == std::string::npos || b == std::string::npos ||
+            c == std::string::npos || d == std::string::npos) continue;
+
+        std::string n = entry.substr(0, a);
+        std::string ip = entry.substr(a + 1, b - (a + 1));
+        std::string inc_s = entry.substr(b + 1, c - (b + 1));
+        char st_c = entry[c + 1];
+
+        if (n == node.name) {
+            const MemberStatus st = status_from_char(st_c);
+            if (st != MemberStatus::Alive) {
+                uint64_t inc = 0;
+                try { inc = (uint64_t)std::stoull(inc_s); } catch (...) { inc = 0; }
+                node.refute(inc, st);
+            }
+            continue;
+        }
+
+        if (!n.empty() && !ip.empty()) {
+            merge_member(node, n, ip, inc_s, status_from_char(st_c), now, false);
+        }
+    }
+}
+
+std::string build_piggy_data(Node& node,
+                             const std::string& exclude_name,
+                             size_t k) {
+    std::string out;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+
+        bool compact = false;
+        if (!exclude_name.empty()) {
+            auto peer = node.membership.find(exclude_name);
+            compact = peer != node.membership.end() && speaks_ids(peer->second);
+        }
+
+        auto append = [&](const std::string& name, const MemberInfo& info) {
+            if (!out.empty()) out.push_back(',');
+            out += make_entry(name, info, compact ? node.ids.id_of(name) : std::string());
+        };
+
+        // A suspected or dead recipient is told so, letting it refute.
+        if (!exclude_name.empty()) {
+            auto peer = node.membership.find(exclude_name);
+            if (peer != node.membership.end() && peer->second.status != MemberStatus::Alive)
+                append(exclude_name, peer->second);
+        }
+
+        // Recent changes first, then random entries.
+        size_t picked = 0;
+        for (const auto& name : node.dissemination.take(k, retransmit_limit(node.membership.size()), exclude_name)) {
+            auto it = node.membership.find(name);
+            if (it == node.membership.end() || it->second.ip.empty()) continue;
+            append(name, it->second);
+            picked++;
+        }
+
+        if (picked < k) {
+            std::string random = piggyback_csv_random_k(node, exclude_name, k - picked, compact);
+            if (!random.empty()) {
+                if (!out.empty()) out.push_back(',');
+                out += random;
+            }
+        }
+
+        // Trailers in order of importance, each only if it still fits
+        // next to the digest.
+        constexpr size_t digest_bytes = 2 + 2 + 16;     // " D=" plus hex
+        auto room = [&] {
+            const size_t used = out.size() + 1 + digest_bytes;
+            return used < PIGGY_MAX_BYTES ? PIGGY_MAX_BYTES - used : 0;
+        };
+        auto add_field = [&](const std::string& field) {
+            if (field.empty() || field.size() > room()) return;
+            if (!out.empty()) out.push_back(' ');
+            out += field;
+        };
+
+        add_field(coord_field(node));
+        add_field(meta_field(node, room()));
+        add_field(node.broadcasts.piggy_field(node.membership.size(), room()));
+    }
+
+    if (!out.empty()) out.push_back(' ');
+    out += "D=" + to_hex(node.view_digest.load());
+    return out;
+}
+
+void split_piggy_data(const std::string& data, std::string& csv, PiggyFields& fields) {
+    csv.clear();
+    fields.clear();
+
+    size_t pos = 0;
+    std::string tok;
+    while (next_token(data, pos, tok)) {
+        size_t eq = tok.find('=');
+        if (eq != std::string::npos && tok.find('@') == std::string::npos) {
+            fields[tok.substr(0, eq)] = tok.substr(eq + 1);
+        } else if (csv.empty()) {
+            csv = tok;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "node.h"
+
+// Piggyback data is a comma-separated list of `name@ip@inc@S@lastSeen`
+// entries (`#id@inc@S@lastSeen` towards peers that speak IDs, see
+// member_id.h), optionally followed by space-separated `key=value` fields
+// (`D=<digest>`, `M=<metadata>`, `B=<broadcast>`, `V=<coordinate>`,
+// `I=<id>`). Older nodes ignore the trailing fields.
+
+using PiggyFields = std::map<std::string, std::string>;
+
+// Compact `#id@...` form when `id` is non-empty.
+std::string make_entry(const std::string& name, const MemberInfo& info, const std::string& id = "");
+
+// Up to k random entries plus this node's trailer fields. Locks membership_mu.
+std::string build_piggy_data(Node& node, const std::string& exclude_name, size_t k);
+
+void split_piggy_data(const std::string& data, std::string& csv, PiggyFields& fields);
+
+// Caller must hold node.membership_mu. IDs we could not resolve are
+// appended to `unknown`, if given, for a WHOIS.
+void apply_piggyback(Node& node, const std::string& csv, std::vector<std::string>* unknown = nullptr);
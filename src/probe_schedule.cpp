@@ -0,0 +1,249 @@
+#include "probe_schedule.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "membership.h"
+#include "membership_config.h"
+#include "node.h"
+
+void ProbeRound::swap_at(size_t a, size_t b) {
+    if (a == b) return;
+    std::swap(order_[a], order_[b]);
+    pos_[order_[a]] = a;
+    pos_[order_[b]] = b;
+}
+
+void ProbeRound::add(const std::string& name) {
+    if (!pos_.emplace(name, order_.size()).second) return;
+    order_.push_back(name);
+}
+
+void ProbeRound::remove(const std::string& name) {
+    auto it = pos_.find(name);
+    if (it == pos_.end()) return;
+
+    // Keep [0, idx_) the probed part: a probed member first trades places
+    // with the last probed one.
+    size_t i = it->second;
+    if (i < idx_) {
+        swap_at(i, idx_ - 1);
+        i = --idx_;
+    }
+    swap_at(i, order_.size() - 1);
+
+    pos_.erase(order_.back());
+    order_.pop_back();
+}
+
+const std::string* ProbeRound::next(std::mt19937& rng) {
+    if (order_.empty()) return nullptr;
+    if (idx_ >= order_.size()) idx_ = 0;
+
+    std::uniform_int_distribution<size_t> pick(idx_, order_.size() - 1);
+    swap_at(idx_, pick(rng));
+    return &order_[idx_++];
+}
+
+void ProbeRound::sample(size_t k, std::mt19937& rng, std::vector<std::string>& out) const {
+    if (order_.size() <= k) {
+        out.insert(out.end(), order_.begin(), order_.end());
+        return;
+    }
+
+    std::uniform_int_distribution<size_t> pick(0, order_.size() - 1);
+    std::vector<size_t> chosen;
+    while (chosen.size() < k) {
+        const size_t i = pick(rng);
+        if (std::find(chosen.begin(), chosen.end(), i) == chosen.end()) chosen.push_back(i);
+    }
+    for (size_t i : chosen) out.push_back(order_[i]);
+}
+
+void ProbeRound::clear() {
+    order_.clear();
+    pos_.clear();
+    idx_ = 0;
+}
+
+void MemberTimers::set(const std::string& name, uint64_t since_ms) {
+    auto [it, inserted] = since_.try_emplace(name, since_ms);
+    if (!inserted) {
+        if (it->second == since_ms) return;
+        order_.erase({ it->second, name });
+        it->second = since_ms;
+    }
+    order_.insert({ since_ms, name });
+}
+
+void MemberTimers::erase(const std::string& name) {
+    auto it = since_.find(name);
+    if (it == since_.end()) return;
+    order_.erase({ it->second, name });
+    since_.erase(it);
+}
+
+std::vector<std::string> MemberTimers::started_before(uint64_t cutoff_ms) const {
+    std::vector<std::string> out;
+    for (const auto& [since, name] : order_) {
+        if (since >= cutoff_ms) break;
+        out.push_back(name);
+    }
+    return out;
+}
+
+void MemberTimers::clear() {
+    order_.clear();
+    since_.clear();
+}
+
+bool ProbeSchedule::in_top(const std::string& zone, const std::string& name) const {
+    auto z = alive_by_zone_.find(zone);
+    if (z == alive_by_zone_.end()) return false;
+
+    size_t n = 0;
+    for (const auto& [rank, member] : z->second) {
+        if (n++ == ZONE_REPRESENTATIVES) break;
+        if (member == name) return true;
+    }
+    return false;
+}
+
+void ProbeSchedule::update(const std::string& name, const MemberInfo* info) {
+    auto it = members_.find(name);
+    if (it != members_.end() && it->second.probeable) {
+        auto z = by_zone_.find(it->second.zone);
+        z->second.remove(name);
+        if (z->second.size() == 0) by_zone_.erase(z);
+    }
+    if (it != members_.end() && it->second.alive) {
+        if (in_top(it->second.zone, name)) remote_stale_ = true;
+        auto z = alive_by_zone_.find(it->second.zone);
+        z->second.erase({ it->second.rank, name });
+        if (z->second.empty()) alive_by_zone_.erase(z);
+    }
+
+    if (!info) {
+        if (it != members_.end()) members_.erase(it);
+        local_.remove(name);
+        remote_.remove(name);
+        known_.remove(name);
+        dead_round_.remove(name);
+        suspects_.erase(name);
+        dead_.erase(name);
+        return;
+    }
+
+    if (it == members_.end()) {
+        it = members_.emplace(name, Entry{}).first;
+        it->second.rank = rep_rank(name);
+    }
+
+    Entry& e = it->second;
+    e.zone = zone_of(*info);
+    e.alive = info->status == MemberStatus::Alive;
+    e.probeable = !is_gone(info->status) && !info->ip.empty();
+
+    if (e.alive) {
+        alive_by_zone_[e.zone].insert({ e.rank, name });
+        if (in_top(e.zone, name)) remote_stale_ = true;
+    }
+
+    if (name == self_) {
+        e.probeable = false;
+        if (e.zone != zone_) {
+            zone_ = e.zone;
+            rebuild_local();
+            remote_stale_ = true;
+        }
+        return;
+    }
+
+    if (info->status == MemberStatus::Suspect) suspects_.set(name, info->suspect_since_ms);
+    else suspects_.erase(name);
+
+    if (is_gone(info->status)) dead_.set(name, info->dead_since_ms);
+    else dead_.erase(name);
+
+    if (!info->ip.empty()) known_.add(name);
+    else known_.remove(name);
+
+    if (e.probeable) by_zone_[e.zone].add(name);
+
+    if (e.probeable && e.zone == zone_) local_.add(name);
+    else local_.remove(name);
+
+    if (info->status == MemberStatus::Dead && !info->ip.empty()) dead_round_.add(name);
+    else dead_round_.remove(name);
+}
+
+void ProbeSchedule::rebuild_local() {
+    local_.clear();
+    for (const auto& [name, e] : members_)
+        if (name != self_ && e.probeable && e.zone == zone_) local_.add(name);
+}
+
+void ProbeSchedule::refresh_remote() {
+    std::unordered_set<std::string> want;
+    if (is_representative()) {
+        for (const auto& [zone, names] : representatives()) {
+            if (zone == zone_) continue;
+            for (const auto& name : names)
+                if (members_.at(name).probeable) want.insert(name);
+        }
+    }
+
+    for (const std::string& name : std::vector<std::string>(remote_.members()))
+        if (!want.count(name)) remote_.remove(name);
+    for (const auto& name : want) remote_.add(name);
+}
+
+ProbeRound& ProbeSchedule::remote() {
+    if (remote_stale_) {
+        refresh_remote();
+        remote_stale_ = false;
+    }
+    return remote_;
+}
+
+const std::string* ProbeSchedule::sample_remote(std::mt19937& rng) {
+    auto it = by_zone_.upper_bound(sample_zone_);
+    for (size_t i = 0; i < by_zone_.size(); i++, ++it) {
+        if (it == by_zone_.end()) it = by_zone_.begin();
+        if (it->first == zone_) continue;
+        sample_zone_ = it->first;
+        return it->second.next(rng);
+    }
+    return nullptr;
+}
+
+ZoneReps ProbeSchedule::representatives() const {
+    ZoneReps reps;
+    for (const auto& [zone, ranked] : alive_by_zone_) {
+        auto& out = reps[zone];
+        for (const auto& [rank, name] : ranked) {
+            if (out.size() == ZONE_REPRESENTATIVES) break;
+            out.push_back(name);
+        }
+    }
+    return reps;
+}
+
+bool ProbeSchedule::is_representative() const {
+    return in_top(zone_, self_);
+}
+
+void ProbeSchedule::clear() {
+    zone_.clear();
+    members_.clear();
+    alive_by_zone_.clear();
+    local_.clear();
+    remote_.clear();
+    known_.clear();
+    dead_round_.clear();
+    remote_stale_ = true;
+    by_zone_.clear();
+    sample_zone_.clear();
+    suspects_.clear();
+    dead_.clear();
+}
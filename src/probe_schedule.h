@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zones.h"
+
+struct MemberInfo;
+
+// One SWIM probe round: each member is probed once per round, in random
+// order. next() draws the target from the members not yet probed this
+// round (one Fisher-Yates step), so a member added mid-round lands at a
+// random point in the rest of it. add, remove and next are O(1).
+class ProbeRound {
+public:
+    void add(const std::string& name);
+    void remove(const std::string& name);
+    bool contains(const std::string& name) const { return pos_.count(name) != 0; }
+
+    // Next target, nullptr if empty. A new round starts after the last one.
+    const std::string* next(std::mt19937& rng);
+
+    // Up to k distinct members, uniformly at random; O(k).
+    void sample(size_t k, std::mt19937& rng, std::vector<std::string>& out) const;
+
+    size_t size() const { return order_.size(); }
+    const std::vector<std::string>& members() const { return order_; }
+    void clear();
+
+private:
+    void swap_at(size_t a, size_t b);
+
+    std::vector<std::string> order_;    // [0, idx_) already probed this round
+    std::unordered_map<std::string, size_t> pos_;
+    size_t idx_ = 0;
+};
+
+// Members ordered by when a timer started (suspicion, death), so expiry
+// looks only at the members that are due.
+class MemberTimers {
+public:
+    void set(const std::string& name, uint64_t since_ms);
+    void erase(const std::string& name);
+
+    // Members whose timer started before `cutoff_ms`, oldest first.
+    std::vector<std::string> started_before(uint64_t cutoff_ms) const;
+
+    size_t size() const { return since_.size(); }
+    void clear();
+
+private:
+    std::set<std::pair<uint64_t, std::string>> order_;
+    std::unordered_map<std::string, uint64_t> since_;
+};
+
+// Probe targets, zone representatives and member timers, kept current by
+// Node::on_member_change and by zone tag changes, so a heartbeat tick costs
+// the same whatever the view size. Only a change of our own zone rebuilds
+// the local round. Guarded by Node::membership_mu.
+class ProbeSchedule {
+public:
+    void set_self(const std::string& name) { self_ = name; }
+
+    // `info` is the member's entry after a change, nullptr once removed.
+    void update(const std::string& name, const MemberInfo* info);
+    void clear();
+
+    // Alive and Suspect members of our zone with an address.
+    ProbeRound& local() { return local_; }
+    // Other zones' representatives while we are one ourselves.
+    ProbeRound& remote();
+    // A member of the next other zone in turn, from that zone's own round;
+    // nullptr in a single zone.
+    const std::string* sample_remote(std::mt19937& rng);
+    // Every other member with an address, for random gossip entries.
+    const ProbeRound& known() const { return known_; }
+    // Dead members with an address, for the occasional re-probe.
+    ProbeRound& dead_round() { return dead_round_; }
+
+    const MemberTimers& suspects() const { return suspects_; }
+    const MemberTimers& dead() const { return dead_; }      // Dead or Left
+
+    // Same result as a scan of the view, in O(zones).
+    ZoneReps representatives() const;
+    bool is_representative() const;
+    const std::string& zone() const { return zone_; }
+
+private:
+    struct Entry {
+        std::string zone;
+        uint64_t rank = 0;
+        bool alive = false;
+        bool probeable = false;     // not Dead or Left, and has an address
+    };
+
+    bool in_top(const std::string& zone, const std::string& name) const;
+    void rebuild_local();
+    void refresh_remote();
+
+    std::string self_;
+    std::string zone_;
+    std::unordered_map<std::string, Entry> members_;
+    std::map<std::string, std::set<std::pair<uint64_t, std::string>>> alive_by_zone_;
+
+    ProbeRound local_;
+    ProbeRound remote_;
+    ProbeRound known_;
+    ProbeRound dead_round_;
+    bool remote_stale_ = true;
+
+    std::map<std::string, ProbeRound> by_zone_;     // probeable, per zone
+    std::string sample_zone_;                       // last zone sampled
+
+    MemberTimers suspects_;
+    MemberTimers dead_;
+};
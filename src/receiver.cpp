@@ -3,19 +3,24 @@
 #include <arpa/inet.h>
 #include <cerrno>
 #include <cstddef>
-#include <iostream>
+#include <string>
 
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <unistd.h>
 
+#include "faults.h"
+#include "log.h"
 #include "node.h"
+#include "sender.h"
+#include "trace.h"
 
 static const uint16_t PORT = 9000;
 
 void udp_receiver_loop(int sock, Node& node) {
-    if (sock < 0) { perror("udp socket"); return; }
+    if (sock < 0) { log_errno("udp socket"); return; }
+    trace_set_thread_name("udp-rx");
 
     timeval tv{};
     tv.tv_sec = 0;
@@ -28,7 +33,7 @@ void udp_receiver_loop(int sock, Node& node) {
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
 
     if (bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("udp bind");
+        log_errno("udp bind");
         return;
     }
 
@@ -38,7 +43,8 @@ void udp_receiver_loop(int sock, Node& node) {
         sockaddr_in from{};
         socklen_t fromlen = sizeof(from);
 
-        ssize_t n = recvfrom(sock, buffer, sizeof(buffer), 0, (sockaddr*)&from, &fromlen);
+        // MSG_TRUNC reports the full length, so a cut-off datagram is seen.
+        ssize_t n = recvfrom(sock, buffer, sizeof(buffer), MSG_TRUNC, (sockaddr*)&from, &fromlen);
         if (n < 0) {
             if (!node.running.load()) break;
 
@@ -48,16 +54,35 @@ void udp_receiver_loop(int sock, Node& node) {
             if (errno == EINTR) continue;
             if (errno == EBADF || errno == EINVAL) break;
 
-            perror("udp recvfrom");
+            log_errno("udp recvfrom");
             continue;
         }
 
+        // Parsing the front of it could accept a half broadcast or entry.
+        if ((size_t)n > sizeof(buffer)) {
+            log_warn("dropped a %zd-byte datagram larger than the receive buffer", n);
+            continue;
+        }
+
+        if (faults_enabled()) {
+            char ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+            std::string payload(buffer, (size_t)n);
+            Node* np = &node;
+            if (fault_apply(FaultDir::In, ip, [np, from, payload] {
+                    np->rx_bytes.fetch_add(payload.size(), std::memory_order_relaxed);
+                    np->udpq.enqueue(from, payload.data(), payload.size());
+                }))
+                continue;
+        }
+
+        node.rx_bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
         node.udpq.enqueue(from, buffer, (size_t)n);
     }
 }
 
 void tcp_receiver_loop(int sock, Node& node) {
-    if (sock < 0) { perror("tcp socket"); return; }
+    if (sock < 0) { log_errno("tcp socket"); return; }
 
     int opt = 1;
     setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
@@ -68,12 +93,12 @@ void tcp_receiver_loop(int sock, Node& node) {
     serverAddress.sin_addr.s_addr = htonl(INADDR_ANY);
 
     if (bind(sock, (sockaddr*)&serverAddress, sizeof(serverAddress)) < 0) {
-        perror("tcp bind");
+        log_errno("tcp bind");
         return;
     }
 
     if (listen(sock, 5) < 0) {
-        perror("tcp listen");
+        log_errno("tcp listen");
         return;
     }
 
@@ -86,25 +111,40 @@ void tcp_receiver_loop(int sock, Node& node) {
             if (!node.running.load()) break;
             if (errno == EBADF || errno == EINVAL) break;
             if (errno == EINTR) continue;
-            perror("tcp accept");
+            log_errno("tcp accept");
+            continue;
+        }
+
+        char buffer[1024];
+
+        // Requests from `measure` are answered on the same connection.
+        int n = recv(client_sock, buffer, sizeof(buffer), 0);
+        if (n > 0 && std::string(buffer, (size_t)n).rfind("MEASURE-DUMP", 0) == 0) {
+            std::string reply = node.transitions.dump(node.name, node.ip);
+            send_all(client_sock, reply.data(), reply.size());
+            close(client_sock);
+            continue;
+        }
+
+        // Event subscribers keep the connection; the event bus owns it now.
+        if (n > 0 && std::string(buffer, (size_t)n).rfind("SUBSCRIBE", 0) == 0) {
+            uint64_t since = 0;
+            try { since = std::stoull(std::string(buffer + 9, (size_t)n - 9)); } catch (...) { since = 0; }
+            node.events.attach_stream(client_sock, since);
             continue;
         }
 
         char ip[INET_ADDRSTRLEN];
         inet_ntop(AF_INET, &peer.sin_addr, ip, sizeof(ip));
-        std::cout << "[TCP connected " << ip << ":" << ntohs(peer.sin_port) << "]\n";
+        log_info("[TCP connected %s:%u]", ip, (unsigned)ntohs(peer.sin_port));
 
-        char buffer[1024];
-        while (node.running.load()) {
-            int n = recv(client_sock, buffer, sizeof(buffer), 0);
-            if (n <= 0) break;
+        while (n > 0 && node.running.load()) {
+            log_info("[TCP] %.*s", n, buffer);
 
-            std::cout << "[TCP] ";
-            std::cout.write(buffer, n);
-            std::cout << "\n" << std::flush;
+            n = recv(client_sock, buffer, sizeof(buffer), 0);
         }
 
         close(client_sock);
-        std::cout << "[TCP disconnected]\n";
+        log_info("[TCP disconnected %s]", ip);
     }
 }
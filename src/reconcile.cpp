@@ -0,0 +1,294 @@
+#include "reconcile.h"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <unordered_set>
+
+#include "hash_util.h"
+#include "membership.h"
+#include "node.h"
+#include "piggyback.h"
+#include "sender.h"
+#include "string_util.h"
+#include "time_util.h"
+
+static constexpr size_t IBLT_SUBTABLE = IBLT_CELLS / IBLT_HASHES;
+static_assert(IBLT_CELLS % IBLT_HASHES == 0, "cells must split evenly into sub-tables");
+
+size_t Iblt::cell_index(uint64_t key, size_t i) {
+    return i * IBLT_SUBTABLE + (size_t)(mix64(key + i * 0x51ed27a3ULL) % IBLT_SUBTABLE);
+}
+
+uint64_t Iblt::check_hash(uint64_t key) {
+    return mix64(key ^ 0xc3a5c85c97cb3127ULL);
+}
+
+void Iblt::insert(uint64_t key) {
+    const uint64_t chk = check_hash(key);
+    for (size_t i = 0; i < IBLT_HASHES; i++) {
+        Cell& c = cells_[cell_index(key, i)];
+        c.count++;
+        c.key_sum ^= key;
+        c.hash_sum ^= chk;
+    }
+}
+
+void Iblt::erase(uint64_t key) {
+    const uint64_t chk = check_hash(key);
+    for (size_t i = 0; i < IBLT_HASHES; i++) {
+        Cell& c = cells_[cell_index(key, i)];
+        c.count--;
+        c.key_sum ^= key;
+        c.hash_sum ^= chk;
+    }
+}
+
+void Iblt::subtract(const Iblt& other) {
+    for (size_t i = 0; i < IBLT_CELLS; i++) {
+        cells_[i].count -= other.cells_[i].count;
+        cells_[i].key_sum ^= other.cells_[i].key_sum;
+        cells_[i].hash_sum ^= other.cells_[i].hash_sum;
+    }
+}
+
+bool Iblt::decode(std::vector<uint64_t>& mine, std::vector<uint64_t>& theirs) const {
+    auto cells = cells_;
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
+
+        for (size_t i = 0; i < IBLT_CELLS; i++) {
+            const Cell c = cells[i];
+            if ((c.count != 1 && c.count != -1) || check_hash(c.key_sum) != c.hash_sum)
+                continue;
+
+            const uint64_t key = c.key_sum;
+            (c.count > 0 ? mine : theirs).push_back(key);
+
+            const uint64_t chk = check_hash(key);
+            for (size_t h = 0; h < IBLT_HASHES; h++) {
+                Cell& d = cells[cell_index(key, h)];
+                d.count -= c.count;
+                d.key_sum ^= key;
+                d.hash_sum ^= chk;
+            }
+            progress = true;
+        }
+    }
+
+    for (const auto& c : cells) {
+        if (c.count != 0 || c.key_sum != 0 || c.hash_sum != 0) return false;
+    }
+    return true;
+}
+
+// Cells are comma-separated `count:keysum:hashsum` in hex; empty cells are
+// left blank.
+std::string Iblt::encode() const {
+    std::string out;
+    for (size_t i = 0; i < IBLT_CELLS; i++) {
+        if (i) out.push_back(',');
+        const Cell& c = cells_[i];
+        if (c.count == 0 && c.key_sum == 0 && c.hash_sum == 0) continue;
+
+        out += std::to_string(c.count);
+        out.push_back(':');
+        out += to_hex(c.key_sum);
+        out.push_back(':');
+        out += to_hex(c.hash_sum);
+    }
+    return out;
+}
+
+bool Iblt::parse(const std::string& s, Iblt& out) {
+    out = Iblt{};
+
+    size_t start = 0;
+    for (size_t i = 0; i < IBLT_CELLS; i++) {
+        size_t comma = s.find(',', start);
+        if (comma == std::string::npos) {
+            if (i != IBLT_CELLS - 1) return false;
+            comma = s.size();
+        }
+
+        std::string cell = s.substr(start, comma - start);
+        start = comma + 1;
+        if (cell.empty()) continue;
+
+        size_t a = cell.find(':');
+        size_t b = (a == std::string::npos) ? std::string::npos : cell.find(':', a + 1);
+        if (b == std::string::npos) return false;
+
+        Cell& c = out.cells_[i];
+        try { c.count = std::stoll(cell.substr(0, a)); } catch (...) { return false; }
+        if (!parse_hex(cell.substr(a + 1, b - a - 1), c.key_sum)) return false;
+        if (!parse_hex(cell.substr(b + 1), c.hash_sum)) return false;
+    }
+    return true;
+}
+
+static Iblt build_iblt(Node& node) {
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+    return node.view_iblt;
+}
+
+// Entries of ours whose keys are in `keys`, comma-separated. Caps the count.
+static std::string entries_for_keys(Node& node, const std::vector<uint64_t>& keys, size_t& count) {
+    std::unordered_set<uint64_t> want(keys.begin(), keys.end());
+    std::string csv;
+    count = 0;
+
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+    for (const auto& [name, info] : node.membership) {
+        if (count >= RECONCILE_MAX_ENTRIES) break;
+        if (info.ip.empty() || !want.count(member_key(name, info))) continue;
+
+        if (!csv.empty()) csv.push_back(',');
+        csv += make_entry(name, info);
+        count++;
+    }
+    return csv;
+}
+
+static std::string random_entries(Node& node, size_t k, size_t& count) {
+    std::vector<std::string> entries;
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        for (const auto& [name, info] : node.membership) {
+            if (info.ip.empty()) continue;
+            entries.push_back(make_entry(name, info));
+        }
+    }
+
+    static thread_local std::mt19937 rng(std::random_device{}());
+    std::shuffle(entries.begin(), entries.end(), rng);
+    if (entries.size() > k) entries.resize(k);
+
+    count = entries.size();
+    std::string csv;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (i) csv.push_back(',');
+        csv += entries[i];
+    }
+    return csv;
+}
+
+static size_t count_entries(const std::string& csv) {
+    if (csv.empty()) return 0;
+    return (size_t)std::count(csv.begin(), csv.end(), ',') + 1;
+}
+
+void Reconciler::on_digest(Node& node, const std::string& peer_name,
+                           const std::string& peer_ip, uint64_t remote_digest) {
+    if (remote_digest == node.view_digest.load()) return;
+
+    const uint64_t now = now_ms();
+
+    // Only entries inside the window matter; drop the rest now and then so
+    // departed peers do not pile up.
+    if (now >= next_prune_ms_) {
+        next_prune_ms_ = now + RECONCILE_MIN_MS;
+        for (auto it = last_sync_ms_.begin(); it != last_sync_ms_.end(); ) {
+            if (now - it->second >= RECONCILE_MIN_MS) it = last_sync_ms_.erase(it);
+            else ++it;
+        }
+    }
+
+    uint64_t& last = last_sync_ms_[peer_name];
+    if (last != 0 && now - last < RECONCILE_MIN_MS) return;
+    last = now;
+
+    Iblt t = build_iblt(node);
+    send_udp(peer_ip, make_msg("SYNC", node, t.encode()));
+    started_++;
+}
+
+void Reconciler::on_sync(Node& node, const std::string& peer_ip, const std::string& data) {
+    Iblt diff;
+    if (!Iblt::parse(data, diff)) return;
+
+    diff.subtract(build_iblt(node));
+
+    std::vector<uint64_t> theirs_only, mine_only;
+    std::string csv;
+    std::string wants;
+    size_t count = 0;
+
+    if (diff.decode(theirs_only, mine_only)) {
+        csv = entries_for_keys(node, mine_only, count);
+
+        for (size_t i = 0; i < theirs_only.size() && i < RECONCILE_MAX_ENTRIES; i++) {
+            if (i) wants.push_back('.');
+            wants += to_hex(theirs_only[i]);
+        }
+    } else {
+        // Too many differences for the table: send a larger random sample.
+        decode_failed_++;
+        csv = random_entries(node, RECONCILE_MAX_ENTRIES, count);
+    }
+
+    std::string reply = csv;
+    if (!wants.empty()) {
+        if (!reply.empty()) reply.push_back(' ');
+        reply += "W=" + wants;
+    }
+
+    send_udp(peer_ip, make_msg("SYNC-DIFF", node, reply));
+    answered_++;
+    entries_sent_ += count;
+}
+
+void Reconciler::on_sync_diff(Node& node, const std::string& peer_ip, const std::string& data) {
+    std::string csv;
+    PiggyFields fields;
+    split_piggy_data(data, csv, fields);
+
+    {
+        std::lock_guard<std::mutex> lk(node.membership_mu);
+        apply_piggyback(node, csv);
+    }
+    entries_received_ += count_entries(csv);
+
+    auto it = fields.find("W");
+    if (it == fields.end() || it->second.empty()) return;
+
+    std::vector<uint64_t> keys;
+    size_t start = 0;
+    while (start <= it->second.size()) {
+        size_t dot = it->second.find('.', start);
+        if (dot == std::string::npos) dot = it->second.size();
+
+        uint64_t k = 0;
+        if (parse_hex(it->second.substr(start, dot - start), k)) keys.push_back(k);
+        start = dot + 1;
+    }
+
+    size_t count = 0;
+    std::string push = entries_for_keys(node, keys, count);
+    if (count == 0) return;
+
+    send_udp(peer_ip, make_msg("SYNC-PUSH", node, push));
+    entries_sent_ += count;
+}
+
+void Reconciler::on_sync_push(Node& node, const std::string& data) {
+    std::string csv;
+    PiggyFields fields;
+    split_piggy_data(data, csv, fields);
+
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+    apply_piggyback(node, csv);
+    entries_received_ += count_entries(csv);
+}
+
+ReconcileStats Reconciler::stats() const {
+    ReconcileStats s;
+    s.started = started_.load();
+    s.answered = answered_.load();
+    s.decode_failed = decode_failed_.load();
+    s.entries_sent = entries_sent_.load();
+    s.entries_received = entries_received_.load();
+    return s;
+}
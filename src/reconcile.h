@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Node;
+
+// Membership views are summarised by a digest: the XOR of member_key()
+// (see membership.h) over every entry. When a peer's digest differs from
+// ours we run one round of set reconciliation with an invertible Bloom
+// lookup table (IBLT):
+//
+//   A -> B  SYNC       A's IBLT
+//   B -> A  SYNC-DIFF  entries only B has, plus W=<keys only A has>
+//   A -> B  SYNC-PUSH  entries for those keys
+//
+// so the bytes exchanged grow with the difference, not with N.
+
+inline constexpr size_t   IBLT_HASHES       = 3;
+inline constexpr size_t   IBLT_CELLS        = 30;   // IBLT_HASHES sub-tables
+inline constexpr uint64_t RECONCILE_MIN_MS  = 3000; // per peer
+inline constexpr size_t   RECONCILE_MAX_ENTRIES = 24;
+
+class Iblt {
+public:
+    void insert(uint64_t key);
+    void erase(uint64_t key);       // undoes insert(key)
+    void subtract(const Iblt& other);
+
+    // Peels the table. `mine` gets keys with count +1, `theirs` keys with
+    // count -1. Returns false if the table could not be fully decoded.
+    bool decode(std::vector<uint64_t>& mine, std::vector<uint64_t>& theirs) const;
+
+    std::string encode() const;
+    static bool parse(const std::string& s, Iblt& out);
+
+private:
+    struct Cell {
+        int64_t count = 0;
+        uint64_t key_sum = 0;
+        uint64_t hash_sum = 0;
+    };
+
+    static size_t cell_index(uint64_t key, size_t i);
+    static uint64_t check_hash(uint64_t key);
+
+    std::array<Cell, IBLT_CELLS> cells_{};
+};
+
+struct ReconcileStats {
+    uint64_t started = 0;       // SYNC sent
+    uint64_t answered = 0;      // SYNC decoded and answered
+    uint64_t decode_failed = 0; // difference too large; fell back to sampling
+    uint64_t entries_sent = 0;
+    uint64_t entries_received = 0;
+};
+
+// Driven from the UdpQueue worker thread only.
+class Reconciler {
+public:
+    // Called after an ACK or WELCOME; starts a SYNC if the sender's digest
+    // differs.
+    void on_digest(Node& node, const std::string& peer_name,
+                   const std::string& peer_ip, uint64_t remote_digest);
+
+    void on_sync(Node& node, const std::string& peer_ip, const std::string& data);
+    void on_sync_diff(Node& node, const std::string& peer_ip, const std::string& data);
+    void on_sync_push(Node& node, const std::string& data);
+
+    ReconcileStats stats() const;
+    void reset() { last_sync_ms_.clear(); next_prune_ms_ = 0; }
+
+private:
+    std::unordered_map<std::string, uint64_t> last_sync_ms_;   // within RECONCILE_MIN_MS
+    uint64_t next_prune_ms_ = 0;
+
+    std::atomic<uint64_t> started_{0};
+    std::atomic<uint64_t> answered_{0};
+    std::atomic<uint64_t> decode_failed_{0};
+    std::atomic<uint64_t> entries_sent_{0};
+    std::atomic<uint64_t> entries_received_{0};
+};
@@ -0,0 +1,82 @@
+#include "ring.h"
+
+#include <algorithm>
+
+#include "hash_util.h"
+
+uint64_t HashRing::key_hash(const std::string& key) {
+    return mix64(fnv1a64(key));
+}
+
+uint64_t HashRing::point(uint64_t name_hash, size_t i) {
+    return mix64(name_hash + 0x9e3779b97f4a7c15ULL * (i + 1));
+}
+
+void HashRing::add(const std::string& name) {
+    if (ids_.count(name)) return;
+
+    uint32_t id;
+    if (!free_ids_.empty()) {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+        names_[id] = name;
+    } else {
+        id = (uint32_t)names_.size();
+        names_.push_back(name);
+    }
+    ids_.emplace(name, id);
+
+    // A colliding point keeps its first owner; remove() only erases its own.
+    const uint64_t h = fnv1a64(name);
+    for (size_t i = 0; i < RING_VNODES; i++) ring_.emplace(point(h, i), id);
+}
+
+void HashRing::remove(const std::string& name) {
+    auto it = ids_.find(name);
+    if (it == ids_.end()) return;
+
+    const uint32_t id = it->second;
+    const uint64_t h = fnv1a64(name);
+    for (size_t i = 0; i < RING_VNODES; i++) {
+        auto p = ring_.find(point(h, i));
+        if (p != ring_.end() && p->second == id) ring_.erase(p);
+    }
+
+    names_[id].clear();
+    free_ids_.push_back(id);
+    ids_.erase(it);
+}
+
+std::string HashRing::owner(const std::string& key) const {
+    if (ring_.empty()) return "";
+    auto it = ring_.lower_bound(key_hash(key));
+    if (it == ring_.end()) it = ring_.begin();
+    return names_[it->second];
+}
+
+std::vector<std::string> HashRing::replicas(const std::string& key, size_t n) const {
+    std::vector<std::string> out;
+    if (ring_.empty() || n == 0) return out;
+
+    n = std::min(n, ids_.size());
+    std::vector<uint32_t> picked;
+
+    auto it = ring_.lower_bound(key_hash(key));
+    for (size_t steps = 0; steps < ring_.size() && picked.size() < n; steps++, ++it) {
+        if (it == ring_.end()) it = ring_.begin();
+
+        bool dup = false;
+        for (uint32_t p : picked) dup = dup || p == it->second;
+        if (!dup) picked.push_back(it->second);
+    }
+
+    for (uint32_t id : picked) out.push_back(names_[id]);
+    return out;
+}
+
+void HashRing::clear() {
+    ring_.clear();
+    names_.clear();
+    ids_.clear();
+    free_ids_.clear();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Consistent-hash ring over Alive members, RING_VNODES points per member.
+// Node::on_member_change adds and removes members as their status changes,
+// so the ring never needs a full rebuild. Lookups are O(log(N * vnodes)).
+// Guarded by Node::membership_mu.
+
+inline constexpr size_t RING_VNODES = 64;
+
+class HashRing {
+public:
+    void add(const std::string& name);
+    void remove(const std::string& name);
+    bool contains(const std::string& name) const { return ids_.count(name) != 0; }
+
+    // Owner of `key`, or "" if the ring is empty.
+    std::string owner(const std::string& key) const;
+
+    // Up to n distinct members clockwise from `key`; the first is the owner.
+    std::vector<std::string> replicas(const std::string& key, size_t n) const;
+
+    size_t members() const { return ids_.size(); }
+    size_t points() const { return ring_.size(); }
+    void clear();
+
+    static uint64_t key_hash(const std::string& key);
+
+private:
+    static uint64_t point(uint64_t name_hash, size_t i);
+
+    std::map<uint64_t, uint32_t> ring_;            // point -> member id
+    std::vector<std::string> names_;               // member id -> name
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<uint32_t> free_ids_;
+};
@@ -1,41 +1,77 @@
 #include "sender.h"
 
+#include <atomic>
 #include <cerrno>
 #include <cstddef>
-#include <iostream>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <unistd.h>
 
+#include "faults.h"
+#include "log.h"
+#include "trace.h"
+
 static const uint16_t PORT = 9000;
 
+static std::atomic<uint64_t> g_udp_tx_bytes{0};
+
+uint64_t udp_bytes_sent() {
+    return g_udp_tx_bytes.load(std::memory_order_relaxed);
+}
+
 bool parse_ipv4(const std::string& ip, in_addr& out) {
     return inet_pton(AF_INET, ip.c_str(), &out) == 1;
 }
 
-bool send_udp(const std::string& ip, const std::string& message) {
+static bool send_udp_now(const std::string& ip, const std::string& message) {
     int sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock < 0) { perror("udp socket"); return false; }
+    if (sock < 0) { log_errno("udp socket"); return false; }
 
     sockaddr_in dst{};
     dst.sin_family = AF_INET;
     dst.sin_port = htons(PORT);
     if (!parse_ipv4(ip, dst.sin_addr)) {
-        std::cerr << "Invalid IPv4 address: " << ip << "\n";
+        log_warn("Invalid IPv4 address: %s", ip.c_str());
         close(sock);
         return false;
     }
 
     ssize_t n = sendto(sock, message.data(), message.size(), 0,
                        (sockaddr*)&dst, sizeof(dst));
-    if (n < 0) { perror("udp sendto"); close(sock); return false; }
+    if (n < 0) { log_errno("udp sendto"); close(sock); return false; }
+
+    g_udp_tx_bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+    trace_packet(TraceKind::PacketOut, ip, message);
 
     close(sock);
     return true;
 }
 
+static std::function<void(const std::string&, const std::string&)> g_udp_tap;
+static std::atomic<bool> g_udp_tapped{false};
+
+void set_udp_tap(std::function<void(const std::string& ip, const std::string& message)> tap) {
+    // Set up by the bench before any node thread runs.
+    g_udp_tapped.store(false, std::memory_order_relaxed);
+    g_udp_tap = std::move(tap);
+    g_udp_tapped.store((bool)g_udp_tap, std::memory_order_relaxed);
+}
+
+bool send_udp(const std::string& ip, const std::string& message) {
+    if (g_udp_tapped.load(std::memory_order_relaxed)) {
+        g_udp_tap(ip, message);
+        return true;
+    }
+    // A datagram the fault layer drops still counts as sent, as on a lossy
+    // network.
+    if (faults_enabled() && fault_apply(FaultDir::Out, ip, [ip, message] { send_udp_now(ip, message); }))
+        return true;
+    return send_udp_now(ip, message);
+}
+
 bool send_all(int sock, const char* data, size_t len) {
     size_t off = 0;
     while (off < len) {
@@ -52,26 +88,77 @@ bool send_all(int sock, const char* data, size_t len) {
 
 bool send_tcp(const std::string& ip, const std::string& message) {
     int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) { perror("tcp socket"); return false; }
+    if (sock < 0) { log_errno("tcp socket"); return false; }
 
     sockaddr_in dst{};
     dst.sin_family = AF_INET;
     dst.sin_port = htons(PORT);
     if (!parse_ipv4(ip, dst.sin_addr)) {
-        std::cerr << "Invalid IPv4 address: " << ip << "\n";
+        log_warn("Invalid IPv4 address: %s", ip.c_str());
         close(sock);
         return false;
     }
 
     if (connect(sock, (sockaddr*)&dst, sizeof(dst)) < 0) {
-        perror("tcp connect");
+        log_errno("tcp connect");
         close(sock);
         return false;
     }
 
     bool ok = send_all(sock, message.data(), message.size());
-    if (!ok) perror("tcp send");
+    if (!ok) log_errno("tcp send");
 
     close(sock);
     return ok;
-}
\ No newline at end of file
+}
+
+int connect_tcp(const std::string& ip, uint64_t timeout_ms) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) { log_errno("tcp socket"); return -1; }
+
+    // On Linux SO_SNDTIMEO also bounds connect().
+    timeval tv{};
+    tv.tv_sec = (time_t)(timeout_ms / 1000);
+    tv.tv_usec = (suseconds_t)((timeout_ms % 1000) * 1000);
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in dst{};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(PORT);
+    if (!parse_ipv4(ip, dst.sin_addr)) {
+        log_warn("Invalid IPv4 address: %s", ip.c_str());
+        close(sock);
+        return -1;
+    }
+
+    if (connect(sock, (sockaddr*)&dst, sizeof(dst)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool request_tcp(const std::string& ip, const std::string& message,
+                 std::string& reply, uint64_t timeout_ms) {
+    int sock = connect_tcp(ip, timeout_ms);
+    if (sock < 0) return false;
+
+    if (!send_all(sock, message.data(), message.size())) {
+        close(sock);
+        return false;
+    }
+    shutdown(sock, SHUT_WR);
+
+    reply.clear();
+    char buffer[4096];
+    while (true) {
+        ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        reply.append(buffer, (size_t)n);
+    }
+
+    close(sock);
+    return !reply.empty();
+}
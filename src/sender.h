@@ -1,19 +1,40 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
 #include "node.h"
 
+// `compact` writes the header as `TYPE #<id> <inc>`; only for recipients
+// where speaks_ids() holds.
 inline std::string make_msg(const std::string& type,
                             const Node& node,
-                            const std::string& data = "") {
+                            const std::string& data = "",
+                            bool compact = false) {
     const std::string inc = std::to_string(node.incarnation);
+    const std::string from = compact ? "#" + node.id : node.name + " " + node.ip;
 
     if (data.empty()) {
-        return type + " " + node.name + " " + node.ip + " " + inc;
+        return type + " " + from + " " + inc;
     }
-    return type + " " + node.name + " " + node.ip + " " + inc + " " + data;
+    return type + " " + from + " " + inc + " " + data;
 }
 
 bool send_udp(const std::string& ip, const std::string& message);
-bool send_tcp(const std::string& ip, const std::string& message);
\ No newline at end of file
+
+// Hands every send_udp() to `tap` instead of the network, for in-process
+// simulations (bench); an empty function restores the socket path.
+void set_udp_tap(std::function<void(const std::string& ip, const std::string& message)> tap);
+
+bool send_tcp(const std::string& ip, const std::string& message);
+bool send_all(int sock, const char* data, size_t len);
+
+// Connected TCP socket to `ip` on our port with send/receive timeouts, or -1.
+int connect_tcp(const std::string& ip, uint64_t timeout_ms);
+
+// Sends `message` over TCP and reads the reply until the peer closes.
+bool request_tcp(const std::string& ip, const std::string& message,
+                 std::string& reply, uint64_t timeout_ms);
+
+uint64_t udp_bytes_sent();
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "shm_publish.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "membership.h"
+#include "membership_config.h"
+#include "node.h"
+#include "time_util.h"
+
+static void copy_field(char* dst, size_t cap, const std::string& src) {
+    const size_t n = std::min(src.size(), cap - 1);
+    std::memcpy(dst, src.data(), n);
+    std::memset(dst + n, 0, cap - n);
+}
+
+void ShmPublisher::start(Node& node, const char* name) {
+    if (th_.joinable()) return;
+
+    const size_t size = shm_segment_size(SHM_CAPACITY);
+    const int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) { log_errno("shm_open"); return; }
+    if (ftruncate(fd, (off_t)size) < 0) { log_errno("shm ftruncate"); close(fd); return; }
+
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) { log_errno("shm mmap"); return; }
+
+    // Reuse the segment across restarts so mapped readers keep working;
+    // the counters only move forward.
+    ShmHeader* h = (ShmHeader*)p;
+    const bool reuse = std::memcmp(h->magic, SHM_MAGIC, sizeof(SHM_MAGIC)) == 0 &&
+                       h->version == SHM_VERSION && h->entry_size == sizeof(ShmMember) &&
+                       h->capacity == SHM_CAPACITY;
+    if (!reuse) {
+        std::memset(p, 0, sizeof(ShmHeader));
+        h->version = SHM_VERSION;
+        h->entry_size = sizeof(ShmMember);
+        h->capacity = SHM_CAPACITY;
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(h->magic, SHM_MAGIC, sizeof(SHM_MAGIC));
+    }
+    copy_field(h->self_name, sizeof(h->self_name), node.name);
+    copy_field(h->self_ip, sizeof(h->self_ip), node.ip);
+    h->writer_pid.store((uint32_t)getpid(), std::memory_order_release);
+
+    node_ = &node;
+    name_ = name;
+    hdr_ = h;
+    size_ = size;
+    published_digest_ = 0;
+
+    publish();
+
+    std::lock_guard<std::mutex> lk(mu_);
+    running_ = true;
+    th_ = std::thread(&ShmPublisher::loop, this);
+}
+
+void ShmPublisher::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (th_.joinable()) th_.join();
+
+    hdr_->writer_pid.store(0, std::memory_order_release);
+    munmap(hdr_, size_);
+    hdr_ = nullptr;
+    node_ = nullptr;
+}
+
+bool ShmPublisher::active() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return running_;
+}
+
+uint64_t ShmPublisher::publishes() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return hdr_ ? hdr_->active.load(std::memory_order_relaxed) : 0;
+}
+
+std::string ShmPublisher::name() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return name_;
+}
+
+// Fills the inactive copy under its sequence counter, then flips `active`.
+// Only this thread (or start(), before it) writes.
+void ShmPublisher::publish() {
+    const uint64_t next = hdr_->active.load(std::memory_order_relaxed) + 1;
+    ShmTable& t = hdr_->tables[next & 1];
+    ShmMember* out = shm_entries(hdr_, next & 1);
+
+    const uint64_t seq = t.seq.load(std::memory_order_relaxed);
+    t.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t count = 0, truncated = 0;
+    uint64_t digest = 0;
+    {
+        std::lock_guard<std::mutex> lk(node_->membership_mu);
+        const uint64_t now = now_ms();
+        const uint64_t wall = wall_ms();
+        digest = node_->view_digest.load(std::memory_order_relaxed);
+
+        for (const auto& [name, info] : node_->membership) {
+            if (count == SHM_CAPACITY) { truncated++; continue; }
+            ShmMember& m = out[count++];
+            copy_field(m.name, sizeof(m.name), name);
+            copy_field(m.ip, sizeof(m.ip), info.ip);
+            m.incarnation = info.incarnation;
+            m.last_seen_wall_ms = wall - std::min(wall, now - std::min(now, info.last_seen_ms));
+            m.status = status_char(info.status);
+            std::memset(m.pad, 0, sizeof(m.pad));
+        }
+    }
+
+    t.publish = next;
+    t.view_digest = digest;
+    t.wall_ms = wall_ms();
+    t.count = count;
+    t.truncated = truncated;
+
+    t.seq.store(seq + 2, std::memory_order_release);
+    hdr_->active.store(next, std::memory_order_release);
+    published_digest_ = digest;
+}
+
+void ShmPublisher::loop() {
+    using clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lk(mu_);
+    auto next_refresh = clock::now() + std::chrono::milliseconds(SHM_REFRESH_MS);
+
+    while (running_) {
+        cv_.wait_for(lk, std::chrono::milliseconds(SHM_PUBLISH_MS), [&]{ return !running_; });
+        if (!running_) break;
+
+        const bool changed = node_->view_digest.load() != published_digest_;
+        if (!changed && clock::now() < next_refresh) continue;
+        next_refresh = clock::now() + std::chrono::milliseconds(SHM_REFRESH_MS);
+
+        lk.unlock();
+        publish();
+        lk.lock();
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "shm_view.h"
+
+class Node;
+
+// Publishes the membership view into the POSIX shared-memory segment that
+// ShmView reads. The segment outlives the node; on stop it is marked as no
+// longer live and keeps the last table.
+class ShmPublisher {
+public:
+    void start(Node& node, const char* name = SHM_NAME);
+    void stop();
+
+    bool active() const;
+    uint64_t publishes() const;
+    std::string name() const;
+
+private:
+    void loop();
+    void publish();
+
+    Node* node_ = nullptr;
+    std::thread th_;
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    bool running_ = false;
+
+    std::string name_;
+    ShmHeader* hdr_ = nullptr;
+    size_t size_ = 0;
+    uint64_t published_digest_ = 0;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+// Header-only reader for the membership table a running node publishes in
+// POSIX shared memory. Include this file alone; it needs nothing else from
+// gds.
+//
+// The segment holds two copies of the table. The node rewrites the inactive
+// copy under that copy's sequence counter (odd while writing) and then flips
+// `active`, so readers never block it and a reader only retries if two
+// publishes land within one read.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+inline const char* const SHM_NAME = "/gds-membership";
+
+inline constexpr uint32_t SHM_VERSION  = 1;
+inline constexpr uint32_t SHM_CAPACITY = 16384;   // members per copy
+inline constexpr size_t   SHM_NAME_MAX = 64;      // with the NUL
+
+struct ShmMember {
+    char name[SHM_NAME_MAX];     // NUL-terminated, truncated if longer
+    char ip[16];
+    uint64_t incarnation;
+    uint64_t last_seen_wall_ms;  // wall clock, comparable across processes
+    char status;                 // 'A' Alive, 'S' Suspect, 'D' Dead, 'L' Left
+    char pad[7];
+};
+
+struct ShmTable {
+    std::atomic<uint64_t> seq;   // odd while the writer fills this copy
+    uint64_t publish;            // publish number that filled it
+    uint64_t view_digest;
+    uint64_t wall_ms;            // when it was published
+    uint32_t count;
+    uint32_t truncated;          // members left out past SHM_CAPACITY
+};
+
+struct ShmHeader {
+    char magic[8];               // "GDSSHM1", written last
+    uint32_t version;
+    uint32_t entry_size;
+    uint32_t capacity;
+    std::atomic<uint32_t> writer_pid;   // 0 once the node stopped
+    std::atomic<uint64_t> active;       // publish count; copy active & 1 is current
+    char self_name[SHM_NAME_MAX];
+    char self_ip[16];
+    ShmTable tables[2];
+};
+
+static_assert(sizeof(ShmMember) == 104, "ShmMember layout is shared with other processes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs lock-free 64-bit atomics");
+
+inline constexpr char SHM_MAGIC[8] = { 'G', 'D', 'S', 'S', 'H', 'M', '1', '\0' };
+
+inline size_t shm_segment_size(uint32_t capacity) {
+    return sizeof(ShmHeader) + 2 * (size_t)capacity * sizeof(ShmMember);
+}
+
+inline ShmMember* shm_entries(ShmHeader* h, size_t copy) {
+    return (ShmMember*)((char*)h + sizeof(ShmHeader)) + copy * h->capacity;
+}
+
+inline const ShmMember* shm_entries(const ShmHeader* h, size_t copy) {
+    return (const ShmMember*)((const char*)h + sizeof(ShmHeader)) + copy * h->capacity;
+}
+
+class ShmView {
+public:
+    ShmView() = default;
+    ShmView(const ShmView&) = delete;
+    ShmView& operator=(const ShmView&) = delete;
+    ~ShmView() { close(); }
+
+    // False if no node has published under `name` yet.
+    bool open(const char* name = SHM_NAME) {
+        close();
+        const int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) return false;
+
+        struct stat st{};
+        if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(ShmHeader)) { ::close(fd); return false; }
+
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+
+        const ShmHeader* h = (const ShmHeader*)p;
+        if (std::memcmp(h->magic, SHM_MAGIC, sizeof(SHM_MAGIC)) != 0 || h->version != SHM_VERSION ||
+            h->entry_size != sizeof(ShmMember) || shm_segment_size(h->capacity) > (size_t)st.st_size) {
+            munmap(p, (size_t)st.st_size);
+            return false;
+        }
+
+        hdr_ = h;
+        size_ = (size_t)st.st_size;
+        return true;
+    }
+
+    void close() {
+        if (hdr_) munmap((void*)hdr_, size_);
+        hdr_ = nullptr;
+        size_ = 0;
+    }
+
+    bool is_open() const { return hdr_ != nullptr; }
+
+    // Changes on every publish; cheap enough to poll before re-reading.
+    uint64_t version() const { return hdr_ ? hdr_->active.load(std::memory_order_acquire) : 0; }
+
+    // Whether the publishing node is still running.
+    bool live() const { return hdr_ && hdr_->writer_pid.load(std::memory_order_relaxed) != 0; }
+
+    std::string self_name() const { return hdr_ ? std::string(hdr_->self_name) : ""; }
+    std::string self_ip() const { return hdr_ ? std::string(hdr_->self_ip) : ""; }
+
+    // Zero-copy read: calls f(const ShmMember* members, size_t count,
+    // const ShmTable& table) on the current copy, members sorted by name.
+    // f may run more than once if the writer overtakes it, so it must only
+    // act on what it saw once read() returns true.
+    template <class F>
+    bool read(F&& f, int max_tries = 64) const {
+        if (!hdr_) return false;
+        for (int i = 0; i < max_tries; i++) {
+            const uint64_t a = hdr_->active.load(std::memory_order_acquire);
+            const ShmTable& t = hdr_->tables[a & 1];
+
+            const uint64_t s1 = t.seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+
+            const size_t n = std::min<size_t>(t.count, hdr_->capacity);
+            f(shm_entries(hdr_, a & 1), n, t);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (t.seq.load(std::memory_order_relaxed) == s1) return true;
+        }
+        return false;
+    }
+
+    // Copies a consistent table.
+    bool snapshot(std::vector<ShmMember>& out, uint64_t* publish = nullptr) const {
+        return read([&](const ShmMember* m, size_t n, const ShmTable& t) {
+            out.assign(m, m + n);
+            if (publish) *publish = t.publish;
+        });
+    }
+
+    bool find(const std::string& name, ShmMember& out) const {
+        bool found = false;
+        const bool ok = read([&](const ShmMember* m, size_t n, const ShmTable&) {
+            found = false;
+            size_t lo = 0, hi = n;
+            while (lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                const int c = std::strncmp(m[mid].name, name.c_str(), SHM_NAME_MAX);
+                if (c == 0) { out = m[mid]; found = true; return; }
+                if (c < 0) lo = mid + 1; else hi = mid;
+            }
+        });
+        return ok && found;
+    }
+
+private:
+    const ShmHeader* hdr_ = nullptr;
+    size_t size_ = 0;
+};
@@ -44,4 +44,42 @@ std::string rest_of_line(const std::string& s, size_t pos) {
     while (pos < s.size() && std::isspace((unsigned char)s[pos])) pos++;
     if (pos >= s.size()) return "";
     return s.substr(pos);
-}
\ No newline at end of file
+}
+
+static bool plain_char(unsigned char c) {
+    return std::isalnum(c) || c == '.' || c == '_' || c == '-' || c == '/' || c == '+';
+}
+
+void percent_encode(std::string& out, const std::string& s) {
+    static const char HEX[] = "0123456789abcdef";
+    for (unsigned char c : s) {
+        if (plain_char(c)) {
+            out.push_back((char)c);
+        } else {
+            out.push_back('%');
+            out.push_back(HEX[c >> 4]);
+            out.push_back(HEX[c & 15]);
+        }
+    }
+}
+
+bool percent_decode(const std::string& s, size_t from, size_t to, std::string& out) {
+    auto hex = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    out.clear();
+    for (size_t i = from; i < to; i++) {
+        if (s[i] != '%') { out.push_back(s[i]); continue; }
+        if (i + 2 >= to) return false;
+
+        const int hi = hex(s[i + 1]), lo = hex(s[i + 2]);
+        if (hi < 0 || lo < 0) return false;
+        out.push_back((char)(hi * 16 + lo));
+        i += 2;
+    }
+    return true;
+}
@@ -7,4 +7,9 @@ std::string trim(const std::string& s);
 void split_cmd_args(const std::string& line, std::string& cmd, std::string& args);
 std::vector<std::string> split_ws(const std::string& s);
 bool next_token(const std::string& s, size_t& pos, std::string& out);
-std::string rest_of_line(const std::string& s, size_t pos);
\ No newline at end of file
+std::string rest_of_line(const std::string& s, size_t pos);
+// Appends `s` with everything outside [A-Za-z0-9._/+-] as %xx, so it can sit
+// inside a single wire token.
+void percent_encode(std::string& out, const std::string& s);
+// Decodes s[from, to) into `out`; false on a malformed escape.
+bool percent_decode(const std::string& s, size_t from, size_t to, std::string& out);
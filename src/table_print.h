@@ -5,7 +5,3 @@
 
 void print_table(const std::vector<std::string>& headers,
                  const std::vector<std::vector<std::string>>& rows);
-
-void print_table_live(const std::vector<std::string>& headers,
-                      const std::vector<std::vector<std::string>>& rows,
-                      size_t& previous_height);
\ No newline at end of file
@@ -1,8 +1,27 @@
 #include "time_util.h"
 
+#include <atomic>
 #include <chrono>
 
+static std::atomic<uint64_t> g_sim_us{0};
+
+void set_sim_clock_us(uint64_t us) {
+    g_sim_us.store(us, std::memory_order_relaxed);
+}
+
 uint64_t now_ms() {
+    if (uint64_t sim = g_sim_us.load(std::memory_order_relaxed)) return sim / 1000;
     using namespace std::chrono;
     return (uint64_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
-}
\ No newline at end of file
+}
+
+uint64_t now_us() {
+    if (uint64_t sim = g_sim_us.load(std::memory_order_relaxed)) return sim;
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t wall_ms() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
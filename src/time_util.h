@@ -2,4 +2,10 @@
 
 #include <cstdint>
 
-uint64_t now_ms();
\ No newline at end of file
+uint64_t now_ms();
+uint64_t now_us();
+uint64_t wall_ms();
+
+// Makes now_ms()/now_us() return `us` for in-process simulations (bench);
+// 0 goes back to the steady clock. Unset, it costs one relaxed load.
+void set_sim_clock_us(uint64_t us);
@@ -0,0 +1,90 @@
+#include "tombstones.h"
+
+#include <arpa/inet.h>
+
+#include "hash_util.h"
+#include "membership_config.h"
+
+void Tombstones::add(const std::string& name, uint64_t incarnation, const std::string& ip, uint64_t now) {
+    const uint64_t key = fnv1a64(name);
+
+    Entry e;
+    e.incarnation = incarnation;
+    e.expires_ms = now + TOMBSTONE_MS;
+    in_addr a{};
+    if (inet_pton(AF_INET, ip.c_str(), &a) == 1) e.ipv4 = a.s_addr;
+
+    map_[key] = e;
+    order_.emplace_back(key, e.expires_ms);
+
+    while (map_.size() > MAX_TOMBSTONES) evict_oldest();
+}
+
+void Tombstones::erase(const std::string& name) {
+    // The stale order_ record is skipped when it reaches the front.
+    map_.erase(fnv1a64(name));
+}
+
+bool Tombstones::suppresses(const std::string& name, uint64_t incarnation) const {
+    if (map_.empty()) return false;
+    auto it = map_.find(fnv1a64(name));
+    return it != map_.end() && incarnation <= it->second.incarnation;
+}
+
+void Tombstones::evict_oldest() {
+    while (!order_.empty()) {
+        auto [key, expires] = order_.front();
+        order_.pop_front();
+
+        auto it = map_.find(key);
+        if (it != map_.end() && it->second.expires_ms == expires) {
+            map_.erase(it);
+            return;
+        }
+    }
+}
+
+void Tombstones::expire(uint64_t now) {
+    while (!order_.empty() && order_.front().second <= now) {
+        auto [key, expires] = order_.front();
+        order_.pop_front();
+
+        auto it = map_.find(key);
+        if (it != map_.end() && it->second.expires_ms == expires) map_.erase(it);
+    }
+
+    // Drop records made stale by erase() or re-adds once they dominate.
+    if (order_.size() > 2 * map_.size() + 64) {
+        std::deque<std::pair<uint64_t, uint64_t>> live;
+        for (const auto& [key, expires] : order_) {
+            auto it = map_.find(key);
+            if (it != map_.end() && it->second.expires_ms == expires) live.emplace_back(key, expires);
+        }
+        order_.swap(live);
+    }
+}
+
+uint32_t Tombstones::random_ipv4(std::mt19937& rng) const {
+    if (order_.empty()) return 0;
+
+    std::uniform_int_distribution<size_t> pick(0, order_.size() - 1);
+    for (int tries = 0; tries < 4; tries++) {
+        const auto& [key, expires] = order_[pick(rng)];
+        auto it = map_.find(key);
+        if (it != map_.end() && it->second.expires_ms == expires && it->second.ipv4) return it->second.ipv4;
+    }
+    return 0;
+}
+
+void Tombstones::clear() {
+    map_.clear();
+    order_.clear();
+}
+
+size_t Tombstones::memory_bytes() const {
+    // Hash node (value + next pointer + cached hash), bucket array, order queue.
+    const size_t node = sizeof(std::pair<const uint64_t, Entry>) + 2 * sizeof(void*);
+    return map_.size() * node
+         + map_.bucket_count() * sizeof(void*)
+         + order_.size() * sizeof(std::pair<uint64_t, uint64_t>);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+// Compact records of reclaimed Dead members. A tombstone keeps only a hash
+// of the name, the incarnation it died with and its address, so stale gossip
+// about the member cannot bring it back but the member can still be
+// re-probed. Guarded by Node::membership_mu.
+class Tombstones {
+public:
+    struct Entry {
+        uint64_t incarnation = 0;
+        uint64_t expires_ms = 0;
+        uint32_t ipv4 = 0;      // network order, for re-probing; 0 if unknown
+    };
+
+    void add(const std::string& name, uint64_t incarnation, const std::string& ip, uint64_t now);
+    void erase(const std::string& name);
+
+    // True if gossip claiming `name` at `incarnation` is older than its death.
+    bool suppresses(const std::string& name, uint64_t incarnation) const;
+
+    void expire(uint64_t now);
+    void clear();
+
+    // Address (network order) of a random tombstone that has one, 0 if none
+    // was found in a few draws.
+    uint32_t random_ipv4(std::mt19937& rng) const;
+
+    size_t size() const { return map_.size(); }
+    size_t memory_bytes() const;
+
+private:
+    void evict_oldest();
+
+    std::unordered_map<uint64_t, Entry> map_;
+    std::deque<std::pair<uint64_t, uint64_t>> order_; // (key, expires_ms), oldest first
+};
@@ -0,0 +1,307 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+#include "time_util.h"
+
+static const char* const MSG_NAMES[] = {
+    "?",
+    "JOIN", "WELCOME",
+    "PING", "ACK",
+    "PING-REQ", "PING-REQ2", "ACK-REQ", "ACK-REQ2",
+    "PING-TEST", "ACK-TEST",
+    "SYNC", "SYNC-DIFF", "SYNC-PUSH",
+    "REDIRECT",
+    "SUSPECT", "ALIVE", "CONFIRM",
+    "BCAST",
+    "WHOIS", "IAM",
+    "DISCOVER",
+    "LEAVE",
+};
+
+static const char* const KIND_NAMES[] = {
+    "none",
+    "pkt-in", "pkt-out",
+    "probe", "escalate", "suspect", "dead",
+    "merge-new", "merge-status", "merge-inc",
+    "incarnation", "refute", "reprobe",
+};
+
+static const char* const STATUS_NAMES[] = { "Alive", "Suspect", "Dead", "Left" };
+
+static constexpr size_t MSG_COUNT  = sizeof(MSG_NAMES) / sizeof(MSG_NAMES[0]);
+static constexpr size_t KIND_COUNT = sizeof(KIND_NAMES) / sizeof(KIND_NAMES[0]);
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "ring size must be a power of two");
+
+struct TraceRing {
+    std::atomic<uint64_t> head{0};
+    std::atomic<bool> in_use{false};
+    char thread_name[16] = {};
+    TraceEvent ev[TRACE_RING_SIZE];
+};
+
+// Rings are never freed: a ring released by an exiting thread is handed to
+// the next new thread, so history survives stop/start cycles.
+static std::mutex g_rings_mu;
+static std::vector<TraceRing*> g_rings;
+static std::atomic<bool> g_enabled{true};
+
+static TraceRing* acquire_ring() {
+    std::lock_guard<std::mutex> lk(g_rings_mu);
+    for (TraceRing* r : g_rings) {
+        bool expected = false;
+        if (r->in_use.compare_exchange_strong(expected, true)) return r;
+    }
+    TraceRing* r = new TraceRing();
+    r->in_use.store(true);
+    std::strncpy(r->thread_name, "thread", sizeof(r->thread_name) - 1);
+    g_rings.push_back(r);
+    return r;
+}
+
+namespace {
+struct RingHandle {
+    TraceRing* ring = nullptr;
+    ~RingHandle() { if (ring) ring->in_use.store(false); }
+};
+}
+
+static TraceRing* local_ring() {
+    static thread_local RingHandle h;
+    if (!h.ring) h.ring = acquire_ring();
+    return h.ring;
+}
+
+uint8_t trace_msg_code(const char* type, size_t len) {
+    for (size_t i = 1; i < MSG_COUNT; i++) {
+        if (std::strlen(MSG_NAMES[i]) == len && std::memcmp(MSG_NAMES[i], type, len) == 0)
+            return (uint8_t)i;
+    }
+    return 0;
+}
+
+uint8_t trace_msg_code(const std::string& type) {
+    return trace_msg_code(type.data(), type.size());
+}
+
+const char* trace_msg_name(uint8_t code) {
+    return code < MSG_COUNT ? MSG_NAMES[code] : "?";
+}
+
+const char* trace_kind_name(uint8_t kind) {
+    return kind < KIND_COUNT ? KIND_NAMES[kind] : "?";
+}
+
+void trace_set_thread_name(const char* name) {
+    TraceRing* r = local_ring();
+    std::memset(r->thread_name, 0, sizeof(r->thread_name));
+    std::strncpy(r->thread_name, name, sizeof(r->thread_name) - 1);
+}
+
+void trace_set_enabled(bool on) { g_enabled.store(on, std::memory_order_relaxed); }
+bool trace_enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void trace_record(TraceKind kind, uint8_t msg,
+                  const char* peer, size_t peer_len,
+                  uint64_t a, uint64_t b) {
+    if (!g_enabled.load(std::memory_order_relaxed)) return;
+
+    TraceRing* r = local_ring();
+    const uint64_t h = r->head.load(std::memory_order_relaxed);
+    TraceEvent& e = r->ev[h & (TRACE_RING_SIZE - 1)];
+
+    // Pairs with the fence in trace_dump: a reader that sees any of the
+    // writes below also sees head at h, and so skips this slot.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    e.ts_us = now_us();
+    e.a = a;
+    e.b = b;
+    e.seq = (uint32_t)h;
+    e.kind = (uint8_t)kind;
+    e.msg = msg;
+
+    const size_t n = std::min(peer_len, TRACE_PEER_LEN - 1);
+    std::memcpy(e.peer, peer, n);
+    e.peer[n] = '\0';
+
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+void trace_packet(TraceKind kind, const std::string& peer,
+                  const std::string& message, uint64_t b) {
+    if (!g_enabled.load(std::memory_order_relaxed)) return;
+
+    size_t sp = message.find(' ');
+    if (sp == std::string::npos) sp = message.size();
+
+    trace_record(kind, trace_msg_code(message.data(), sp),
+                 peer.data(), peer.size(), message.size(), b);
+}
+
+// File layout: TraceFileHeader, then per ring a TraceRingHeader followed by
+// `count` events in recording order.
+#pragma pack(push, 1)
+struct TraceFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t event_size;
+    uint64_t steady_us;   // steady clock at dump time
+    uint64_t wall_ms;     // wall clock at dump time
+    uint32_t ring_count;
+};
+
+struct TraceRingHeader {
+    char     thread_name[16];
+    uint64_t count;
+};
+#pragma pack(pop)
+
+static const char TRACE_MAGIC[8] = { 'G', 'D', 'S', 'T', 'R', 'A', 'C', 'E' };
+
+bool trace_dump(const std::string& path, size_t* events_written) {
+    std::vector<TraceRing*> rings;
+    {
+        std::lock_guard<std::mutex> lk(g_rings_mu);
+        rings = g_rings;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    TraceFileHeader fh{};
+    std::memcpy(fh.magic, TRACE_MAGIC, sizeof(fh.magic));
+    fh.version = 1;
+    fh.event_size = sizeof(TraceEvent);
+    fh.steady_us = now_us();
+    fh.wall_ms = wall_ms();
+    fh.ring_count = (uint32_t)rings.size();
+    out.write((const char*)&fh, sizeof(fh));
+
+    size_t total = 0;
+    std::vector<TraceEvent> copy;
+
+    for (TraceRing* r : rings) {
+        const uint64_t h1 = r->head.load(std::memory_order_acquire);
+        const uint64_t first = h1 > TRACE_RING_SIZE ? h1 - TRACE_RING_SIZE : 0;
+
+        copy.clear();
+        for (uint64_t i = first; i < h1; i++)
+            copy.push_back(r->ev[i & (TRACE_RING_SIZE - 1)]);
+
+        // Drop slots the owner may have overwritten while we were copying,
+        // including slot h2 - TRACE_RING_SIZE, which it may be writing now
+        // for event h2 before it moves head. The fence keeps the copy above
+        // from being read after head, as in a seqlock reader.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t h2 = r->head.load(std::memory_order_relaxed);
+        const uint64_t valid_from = h2 >= TRACE_RING_SIZE ? h2 - TRACE_RING_SIZE + 1 : 0;
+        size_t skip = valid_from > first ? (size_t)std::min<uint64_t>(valid_from - first, copy.size()) : 0;
+
+        TraceRingHeader rh{};
+        std::memcpy(rh.thread_name, r->thread_name, sizeof(rh.thread_name));
+        rh.count = copy.size() - skip;
+        out.write((const char*)&rh, sizeof(rh));
+        out.write((const char*)(copy.data() + skip), (std::streamsize)(rh.count * sizeof(TraceEvent)));
+
+        total += rh.count;
+    }
+
+    if (events_written) *events_written = total;
+    return (bool)out;
+}
+
+struct DecodedEvent {
+    TraceEvent ev;
+    std::string thread;
+};
+
+static std::string status_name(uint64_t s) {
+    return s < sizeof(STATUS_NAMES) / sizeof(STATUS_NAMES[0]) ? STATUS_NAMES[s] : std::to_string(s);
+}
+
+bool trace_decode(const std::string& path, std::ostream& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    TraceFileHeader fh{};
+    if (!in.read((char*)&fh, sizeof(fh))) return false;
+    if (std::memcmp(fh.magic, TRACE_MAGIC, sizeof(fh.magic)) != 0) return false;
+    if (fh.version != 1 || fh.event_size != sizeof(TraceEvent)) return false;
+
+    std::vector<DecodedEvent> events;
+
+    for (uint32_t i = 0; i < fh.ring_count; i++) {
+        TraceRingHeader rh{};
+        if (!in.read((char*)&rh, sizeof(rh))) return false;
+
+        std::string thread(rh.thread_name, strnlen(rh.thread_name, sizeof(rh.thread_name)));
+        for (uint64_t j = 0; j < rh.count; j++) {
+            DecodedEvent d;
+            if (!in.read((char*)&d.ev, sizeof(d.ev))) return false;
+            d.thread = thread;
+            events.push_back(std::move(d));
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const DecodedEvent& x, const DecodedEvent& y) {
+        return x.ev.ts_us < y.ev.ts_us;
+    });
+
+    out << "# " << events.size() << " events from " << fh.ring_count << " threads\n";
+
+    for (const auto& d : events) {
+        const TraceEvent& e = d.ev;
+
+        // Convert to wall time relative to the dump instant.
+        const int64_t delta_us = (int64_t)e.ts_us - (int64_t)fh.steady_us;
+        const int64_t wall_us = (int64_t)fh.wall_ms * 1000 + delta_us;
+        const int64_t secs = wall_us / 1000000;
+        const int64_t frac = wall_us % 1000000;
+
+        std::string peer(e.peer, strnlen(e.peer, sizeof(e.peer)));
+
+        out << secs << "." << std::setw(6) << std::setfill('0') << frac << std::setfill(' ')
+            << " " << std::left << std::setw(10) << d.thread
+            << " " << std::setw(12) << trace_kind_name(e.kind) << std::right;
+
+        switch ((TraceKind)e.kind) {
+            case TraceKind::PacketIn:
+                out << " " << trace_msg_name(e.msg) << " from " << peer
+                    << " bytes=" << e.a << " inc=" << e.b;
+                break;
+            case TraceKind::PacketOut:
+                out << " " << trace_msg_name(e.msg) << " to " << peer << " bytes=" << e.a;
+                break;
+            case TraceKind::EscalateIndirect:
+                out << " " << peer << " helpers=" << e.a;
+                break;
+            case TraceKind::MergeNew:
+                out << " " << peer << " inc=" << e.a << " status=" << status_name(e.b);
+                break;
+            case TraceKind::MergeStatus:
+                out << " " << peer << " " << status_name(e.a) << " -> " << status_name(e.b);
+                break;
+            case TraceKind::Refute:
+                out << " " << peer << " claimed " << status_name(e.b) << " at inc " << e.a;
+                break;
+            case TraceKind::MergeIncarnation:
+            case TraceKind::Incarnation:
+                out << " " << peer << " inc " << e.a << " -> " << e.b;
+                break;
+            default:
+                out << " " << peer;
+                break;
+        }
+        out << "\n";
+    }
+
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Protocol flight recorder: every thread owns a fixed-size ring of binary
+// events that it writes without locks. `trace dump` copies all rings to a
+// file; `gds trace <file>` decodes one offline.
+
+inline constexpr size_t TRACE_RING_SIZE = 4096; // events per thread, power of two
+inline constexpr size_t TRACE_PEER_LEN  = 32;
+
+enum class TraceKind : uint8_t {
+    None = 0,
+    PacketIn,          // peer = sender name, a = bytes, b = sender incarnation
+    PacketOut,         // peer = destination ip, a = bytes
+    ProbeStart,        // peer = target
+    EscalateIndirect,  // peer = target, a = helpers asked
+    Suspect,           // peer = target (local probe failure)
+    Dead,              // peer = target (suspicion expired)
+    MergeNew,          // peer = member, a = incarnation, b = status
+    MergeStatus,       // peer = member, a = old status, b = new status
+    MergeIncarnation,  // peer = member, a = old incarnation, b = new incarnation
+    Incarnation,       // peer = self, a = old incarnation, b = new incarnation
+    Refute,            // peer = self, a = claimed incarnation, b = claimed status
+    Reprobe,           // peer = dead member, or a tombstone's address
+};
+
+#pragma pack(push, 1)
+struct TraceEvent {
+    uint64_t ts_us = 0;   // steady clock
+    uint64_t a = 0;
+    uint64_t b = 0;
+    uint32_t seq = 0;
+    uint16_t reserved = 0;
+    uint8_t  kind = 0;
+    uint8_t  msg = 0;
+    char     peer[TRACE_PEER_LEN] = {};
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TraceEvent) == 64, "TraceEvent should stay one cache line");
+
+// Maps a message type token ("PING", "ACK", ...) to a small code; 0 if unknown.
+uint8_t trace_msg_code(const char* type, size_t len);
+uint8_t trace_msg_code(const std::string& type);
+const char* trace_msg_name(uint8_t code);
+const char* trace_kind_name(uint8_t kind);
+
+void trace_set_thread_name(const char* name);
+void trace_set_enabled(bool on);
+bool trace_enabled();
+
+void trace_record(TraceKind kind, uint8_t msg,
+                  const char* peer, size_t peer_len,
+                  uint64_t a = 0, uint64_t b = 0);
+
+inline void trace_record(TraceKind kind, const std::string& peer,
+                         uint64_t a = 0, uint64_t b = 0) {
+    trace_record(kind, 0, peer.data(), peer.size(), a, b);
+}
+
+// Records a datagram; the message type is taken from the first token.
+void trace_packet(TraceKind kind, const std::string& peer,
+                  const std::string& message, uint64_t b = 0);
+
+bool trace_dump(const std::string& path, size_t* events_written = nullptr);
+bool trace_decode(const std::string& path, std::ostream& out);
@@ -7,199 +7,196 @@
 #include <vector>
 #include <mutex>
 
+#include <arpa/inet.h>
+
+#include "hash_util.h"
+#include "membership.h"
 #include "node.h"
+#include "piggyback.h"
 #include "sender.h"
 #include "string_util.h"
 #include "time_util.h"
+#include "trace.h"
 #include "membership_config.h"
 
-static int status_rank(MemberStatus s) {
-    switch (s) {
-        case MemberStatus::Alive:   return 0;
-        case MemberStatus::Suspect: return 1;
-        case MemberStatus::Dead:    return 2;
-        default:                    return 0;
-    }
+void UdpQueue::start(Node& node) {
+    if (running_) return;
+    node_ = &node;
+    running_ = true;
+    th_ = std::thread(&UdpQueue::worker_loop, this);
 }
 
-static char status_char(MemberStatus s) {
-    switch (s) {
-        case MemberStatus::Alive:   return 'A';
-        case MemberStatus::Suspect: return 'S';
-        case MemberStatus::Dead:    return 'D';
-        default:                    return 'A';
+void UdpQueue::stop() {
+    if (!running_) return;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        running_ = false;
     }
-}
+    cv_.notify_all();
+    if (th_.joinable()) th_.join();
 
-static MemberStatus status_from_char(char c) {
-    if (c == 'A') return MemberStatus::Alive;
-    if (c == 'S') return MemberStatus::Suspect;
-    if (c == 'D') return MemberStatus::Dead;
-    return MemberStatus::Alive;
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& l : lanes_) l.q.clear();
+    size_ = 0;
+    node_ = nullptr;
 }
 
+UdpLane udp_lane_of(const char* data, size_t len) {
+    size_t n = 0;
+    while (n < len && data[n] != ' ' && data[n] != '\n') n++;
+    const std::string type(data, n);
 
-// name@ip@inc@S@lastSeen
-static std::string make_entry(const std::string& name, const MemberInfo& info) {
-    std::string e;
-    e.reserve(name.size() + info.ip.size() + 32);
-    e += name;
-    e.push_back('@');
-    e += info.ip;
-    e.push_back('@');
-    e += std::to_string(info.incarnation);
-    e.push_back('@');
-    e.push_back(status_char(info.status));
-    e.push_back('@');
-    e += std::to_string(info.last_seen_ms);
-    return e;
+    if (type == "ACK" || type == "ACK-REQ" || type == "ACK-REQ2") return UdpLane::ProbeReply;
+    if (type == "PING" || type == "PING-REQ" || type == "PING-REQ2") return UdpLane::Probe;
+    if (type == "SUSPECT" || type == "ALIVE" || type == "CONFIRM" || type == "LEAVE") return UdpLane::Probe;
+    if (type == "PING-TEST" || type == "ACK-TEST") return UdpLane::Diagnostic;
+    return UdpLane::Gossip;
 }
 
-static std::string piggyback_csv_random_k(const Node& node,
-                                         const std::string& exclude_name,
-                                         size_t k) {
-    std::vector<std::string> entries;
-    entries.reserve(node.membership.size());
-
-    for (const auto& [n, info] : node.membership) {
-        if (n.empty() || info.ip.empty()) continue;
-        if (n == exclude_name) continue;
-        if (n == node.name) continue;
-        entries.push_back(make_entry(n, info));
+const char* udp_lane_name(UdpLane lane) {
+    switch (lane) {
+        case UdpLane::ProbeReply: return "probe-reply";
+        case UdpLane::Probe:      return "probe";
+        case UdpLane::Gossip:     return "gossip";
+        case UdpLane::Diagnostic: return "diagnostic";
+        default:                  return "?";
     }
-
-    if (entries.empty() || k == 0) return "";
-
-    static thread_local std::mt19937 rng(std::random_device{}());
-    std::shuffle(entries.begin(), entries.end(), rng);
-    if (entries.size() > k) entries.resize(k);
-
-    std::string out;
-    for (size_t i = 0; i < entries.size(); i++) {
-        if (i) out.push_back(',');
-        out += entries[i];
-    }
-    return out;
 }
 
-static void merge_member(Node& node,
-                         const std::string& name,
-                         const std::string& ip,
-                         const std::string& inc_str,
-                         MemberStatus st,
-                         uint64_t last_seen,
-                         bool direct) {
-    MemberInfo& cur = node.membership[name];
-
-    uint64_t inc = 0;
-    try { inc = (uint64_t)std::stoull(inc_str); } catch (...) { inc = 0; }
-
-    if (!ip.empty()) cur.ip = ip;
-
-    if (direct) {
-        cur.status = MemberStatus::Alive;
-        cur.last_seen_ms = last_seen;
-        cur.incarnation = inc;
-        return;
-    }
+void UdpQueue::set_policy(OverloadPolicy p) {
+    std::lock_guard<std::mutex> lk(mu_);
+    policy_ = p;
+}
 
-    if (inc > cur.incarnation) {
-        cur.incarnation = inc;
-        cur.status = st;
-        return;
-    } else if (inc < cur.incarnation) {
-        return;
-    } else if (status_rank(st) > status_rank(cur.status)) {
-        cur.status = st;
-    }
+OverloadPolicy UdpQueue::policy() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return policy_;
 }
 
-static void apply_piggyback(Node& node, const std::string& csv) {
-    if (csv.empty()) return;
+// Frees one slot for a datagram in `incoming`; false means drop the
+// incoming datagram instead. Caller holds mu_.
+bool UdpQueue::evict_locked(UdpLane incoming) {
+    Lane* victim = nullptr;
 
-    size_t start = 0;
-    while (start < csv.size()) {
-        size_t comma = csv.find(',', start);
-        if (comma == std::string::npos) comma = csv.size();
+    if (policy_ == OverloadPolicy::DropOldest) {
+        for (auto& l : lanes_) {
+            if (l.q.empty()) continue;
+            if (!victim || l.q.front().seq < victim->q.front().seq) victim = &l;
+        }
+    } else {
+        for (size_t i = UDP_LANES; i-- > (size_t)incoming; ) {
+            if (!lanes_[i].q.empty()) { victim = &lanes_[i]; break; }
+        }
+        // Nothing ranks below the arrival: shed the arrival itself.
+        if (victim == &lanes_[(size_t)incoming]) victim = nullptr;
+    }
 
-        std::string entry = csv.substr(start, comma - start);
+    if (!victim) return false;
 
-        size_t a = entry.find('@');
-        size_t b = (a == std::string::npos) ? std::string::npos : entry.find('@', a + 1);
-        size_t c = (b == std::string::npos) ? std::string::npos : entry.find('@', b + 1);
-        size_t d = (c == std::string::npos) ? std::string::npos : entry.find('@', c + 1);
+    victim->q.pop_front();
+    victim->dropped++;
+    size_--;
+    return true;
+}
 
-        if (a != std::string::npos && b != std::string::npos &&
-            c != std::string::npos && d != std::string::npos) {
+void UdpQueue::enqueue(const sockaddr_in& from, const char* data, size_t len) {
+    const UdpLane lane = udp_lane_of(data, len);
 
-            std::string n = entry.substr(0, a);
-            std::string ip = entry.substr(a + 1, b - (a + 1));
-            std::string inc_s = entry.substr(b + 1, c - (b + 1));
-            char st_c = entry[c + 1];
+    UdpEvent ev;
+    ev.from = from;
+    ev.payload.assign(data, data + len);
+    ev.enqueued_us = now_us();
 
-            if (n == node.name) { start = comma + 1; continue; }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        Lane& l = lanes_[(size_t)lane];
+        l.arrived++;
 
-            if (!n.empty() && !ip.empty()) {
-                merge_member(node, n, ip, inc_s, status_from_char(st_c), 0, false);
-            }
+        if (size_ >= UDPQ_CAPACITY && !evict_locked(lane)) {
+            l.dropped++;
+            return;
         }
 
-        start = comma + 1;
+        ev.seq = next_seq_++;
+        l.q.push_back(std::move(ev));
+        l.max_depth = std::max<uint64_t>(l.max_depth, l.q.size());
+        size_++;
     }
+    cv_.notify_one();
 }
 
-static std::string build_piggy_data(Node& node,
-                                    const std::string& exclude_name,
-                                    size_t k) {
-    std::lock_guard<std::mutex> lk(node.membership_mu);
-    return piggyback_csv_random_k(node, exclude_name, k);
-}
-
-void UdpQueue::start(Node& node) {
-    if (running_) return;
-    node_ = &node;
-    running_ = true;
-    th_ = std::thread(&UdpQueue::worker_loop, this);
+void UdpQueue::record_wait_locked(UdpLane lane, uint64_t wait_us) {
+    Lane& l = lanes_[(size_t)lane];
+    size_t b = 0;
+    while (b + 1 < WAIT_BUCKETS && (wait_us >> b) > 1) b++;
+    l.wait_hist[b]++;
+    l.wait_max_us = std::max(l.wait_max_us, wait_us);
 }
 
-void UdpQueue::stop() {
-    if (!running_) return;
-    {
-        std::lock_guard<std::mutex> lk(mu_);
-        running_ = false;
-    }
-    cv_.notify_all();
-    if (th_.joinable()) th_.join();
-
+UdpLaneStats UdpQueue::lane_stats(UdpLane lane) const {
     std::lock_guard<std::mutex> lk(mu_);
-    q_.clear();
-    node_ = nullptr;
-}
+    const Lane& l = lanes_[(size_t)lane];
+
+    UdpLaneStats st;
+    st.arrived = l.arrived;
+    st.dropped = l.dropped;
+    st.depth = l.q.size();
+    st.max_depth = l.max_depth;
+    st.wait_max_us = l.wait_max_us;
+
+    uint64_t total = 0;
+    for (uint64_t c : l.wait_hist) total += c;
+
+    // Upper bound of the bucket holding the percentile.
+    auto percentile = [&](uint64_t pct) -> uint64_t {
+        if (total == 0) return 0;
+        const uint64_t rank = (total * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < WAIT_BUCKETS; b++) {
+            seen += l.wait_hist[b];
+            if (seen >= rank) return std::min<uint64_t>(2ULL << b, l.wait_max_us);
+        }
+        return l.wait_max_us;
+    };
 
-void UdpQueue::enqueue(const sockaddr_in& from, const char* data, size_t len) {
-    UdpEvent ev;
-    ev.from = from;
-    ev.payload.assign(data, data + len);
+    st.wait_p50_us = percentile(50);
+    st.wait_p99_us = percentile(99);
+    return st;
+}
 
-    {
-        std::lock_guard<std::mutex> lk(mu_);
-        q_.push_back(std::move(ev));
+void UdpQueue::reset_stats() {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& l : lanes_) {
+        l.arrived = 0;
+        l.dropped = 0;
+        l.max_depth = l.q.size();
+        l.wait_max_us = 0;
+        std::fill(std::begin(l.wait_hist), std::end(l.wait_hist), 0);
     }
-    cv_.notify_one();
 }
 
 void UdpQueue::worker_loop() {
+    trace_set_thread_name("udp-worker");
+
     while (true) {
         UdpEvent ev;
 
         {
             std::unique_lock<std::mutex> lk(mu_);
-            cv_.wait(lk, [&]{ return !running_ || !q_.empty(); });
+            cv_.wait(lk, [&]{ return !running_ || size_ > 0; });
+
+            if (!running_ && size_ == 0) break;
 
-            if (!running_ && q_.empty()) break;
+            for (size_t i = 0; i < UDP_LANES; i++) {
+                Lane& l = lanes_[i];
+                if (l.q.empty()) continue;
 
-            ev = std::move(q_.front());
-            q_.pop_front();
+                ev = std::move(l.q.front());
+                l.q.pop_front();
+                size_--;
+                record_wait_locked((UdpLane)i, now_us() - ev.enqueued_us);
+                break;
+            }
         }
 
         if (node_) handle_datagram(ev.from, ev.payload);
@@ -207,7 +204,6 @@ void UdpQueue::worker_loop() {
 }
 
 void UdpQueue::handle_datagram(const sockaddr_in& from, const std::string& payload) {
-    (void)from;
     if (!node_) return;
 
     std::string msg = trim(payload);
@@ -219,25 +215,142 @@ void UdpQueue::handle_datagram(const sockaddr_in& from, const std::string& paylo
     // parse payload
     next_token(msg, pos, type);
     next_token(msg, pos, sender_name);
-    next_token(msg, pos, sender_ip);
+
+    // Compact header: `TYPE #<id> <inc>`.
+    std::string header_id;
+    if (!sender_name.empty() && sender_name[0] == '#') {
+        header_id = sender_name.substr(1);
+        sender_name.clear();
+    } else {
+        next_token(msg, pos, sender_ip);
+    }
     next_token(msg, pos, sender_inc);
 
     std::string data = rest_of_line(msg, pos);
 
+    std::vector<std::string> unknown_ids;
+    if (!header_id.empty()) {
+        {
+            std::lock_guard<std::mutex> lk(node_->membership_mu);
+            if (const std::string* n = node_->ids.resolve(header_id)) {
+                auto it = node_->membership.find(*n);
+                if (it != node_->membership.end()) {
+                    sender_name = *n;
+                    sender_ip = it->second.ip;
+                }
+            }
+        }
+
+        // Still answerable at the source address; the WHOIS below fills in
+        // the name.
+        if (sender_name.empty()) {
+            char buf[INET_ADDRSTRLEN] = {};
+            inet_ntop(AF_INET, &from.sin_addr, buf, sizeof(buf));
+            sender_ip = buf;
+            unknown_ids.push_back(header_id);
+        }
+    }
+
+    {
+        uint64_t inc = 0;
+        try { inc = (uint64_t)std::stoull(sender_inc); } catch (...) { inc = 0; }
+        trace_record(TraceKind::PacketIn, trace_msg_code(type),
+                     sender_name.data(), sender_name.size(), payload.size(), inc);
+    }
+
+    const bool gossip = (type == "JOIN" || type == "WELCOME" || type == "PING" || type == "ACK");
+    const bool update = (type == "SUSPECT" || type == "ALIVE" || type == "CONFIRM" || type == "LEAVE" ||
+                         type == "IAM");
+
+    std::string piggy_csv;
+    PiggyFields fields;
+    if (gossip) split_piggy_data(data, piggy_csv, fields);
+
     const uint64_t now = now_ms();
+    bool reply_compact = false;
+    std::string sender_id;
+    std::string whois;
     {
         std::lock_guard<std::mutex> lk(node_->membership_mu);
-        if (type == "JOIN" || type == "WELCOME" || type == "PING" || type == "ACK") {
-            apply_piggyback(*node_, data);
+        if (gossip) {
+            apply_piggyback(*node_, piggy_csv, &unknown_ids);
+        }
+        if (update) {
+            apply_piggyback(*node_, data, &unknown_ids);
         }
         if (!sender_name.empty() && !sender_ip.empty()) {
             merge_member(*node_, sender_name, sender_ip, sender_inc, MemberStatus::Alive, now, true);
+
+            auto it = node_->membership.find(sender_name);
+            if (it != node_->membership.end()) {
+                // The sender proves it knows us by our ID.
+                auto i = fields.find("I");
+                if (i != fields.end() && i->second == node_->id) {
+                    it->second.id_ack = true;
+                    it->second.id_ack_inc = it->second.incarnation;
+                }
+                reply_compact = speaks_ids(it->second);
+            }
+            if (header_id.empty()) sender_id = node_->ids.id_of(sender_name);
+        }
+
+        for (const auto& id : unknown_ids) {
+            if (!node_->ids.should_ask(id, now)) continue;
+            if (!whois.empty()) whois.push_back(',');
+            whois += id;
+        }
+
+        auto v = fields.find("V");
+        if (v != fields.end() && !sender_name.empty() && sender_name != node_->name) {
+            auto it = node_->membership.find(sender_name);
+            if (it != node_->membership.end() && decode_coord(v->second, it->second.coord))
+                it->second.has_coord = true;
+        }
+
+        auto m = fields.find("M");
+        if (m != fields.end()) {
+            std::string meta_name;
+            uint64_t meta_version = 0;
+            Meta meta;
+            if (decode_meta(m->second, meta_name, meta_version, meta))
+                merge_meta(*node_, meta_name, meta_version, std::move(meta));
         }
     }
 
+    // Refutations triggered above go out before we answer.
+    push_updates(*node_);
+
+    if (!whois.empty()) send_udp(sender_ip, make_msg("WHOIS", *node_, whois));
+
+    if (update) return;
+
+    if (gossip) {
+        auto b = fields.find("B");
+        if (b != fields.end()) node_->broadcasts.receive(*node_, b->second, false);
+    }
+
+    if (type == "BCAST") {
+        node_->broadcasts.receive(*node_, data, true);
+        return;
+    }
+
     if (type == "JOIN") {
-        std::string piggy_msg = build_piggy_data(*node_, sender_name, PIGGY_K);
-        std::string reply = make_msg("WELCOME", *node_, piggy_msg);
+        uint64_t inc = 0;
+        try { inc = (uint64_t)std::stoull(sender_inc); } catch (...) { inc = 0; }
+
+        JoinGate& gate = node_->join_gate;
+        const JoinAction action = gate.admit(sender_name, inc, now, node_->is_seed);
+        if (action == JoinAction::Drop) return;
+
+        if (action == JoinAction::Redirect) {
+            std::string targets = gate.redirect_targets(*node_, sender_name, now);
+            if (!targets.empty()) {
+                send_udp(sender_ip, make_msg("REDIRECT", *node_, targets));
+                return;
+            }
+        }
+
+        std::string reply = make_msg("WELCOME", *node_, gate.welcome_payload(*node_, now));
         send_udp(sender_ip, reply);
         return;
     }
@@ -245,18 +358,79 @@ void UdpQueue::handle_datagram(const sockaddr_in& from, const std::string& paylo
     if (type == "WELCOME") {
         node_->joined.store(true);
         node_->attempt_join.store(false);
+
+        // The payload holds only a few entries; the digest lets a joiner
+        // (or a warm restart) catch up on the rest.
+        uint64_t digest = 0;
+        auto it = fields.find("D");
+        if (!sender_name.empty() && it != fields.end() && parse_hex(it->second, digest))
+            node_->reconcile.on_digest(*node_, sender_name, sender_ip, digest);
+        return;
+    }
+
+    if (type == "REDIRECT") {
+        if (node_->joined.load()) return;
+
+        std::vector<std::string> hints;
+        size_t start = 0;
+        while (start < data.size()) {
+            size_t comma = data.find(',', start);
+            if (comma == std::string::npos) comma = data.size();
+            std::string h = data.substr(start, comma - start);
+            if (!h.empty() && h != node_->ip) hints.push_back(std::move(h));
+            start = comma + 1;
+        }
+        if (hints.empty()) return;
+
+        const std::string join = make_msg("JOIN", *node_);
+        for (const auto& h : hints) send_udp(h, join);
+
+        std::lock_guard<std::mutex> lk(node_->join_hints_mu);
+        node_->join_hints = std::move(hints);
         return;
     }
 
     if (type == "PING") {
         std::string piggy_msg = build_piggy_data(*node_, sender_name, PIGGY_K);
-        std::string reply = make_msg("ACK", *node_, piggy_msg);
+        // A full header means the sender has no proof we know its ID yet.
+        if (!sender_id.empty()) piggy_msg += " I=" + sender_id;
+        std::string reply = make_msg("ACK", *node_, piggy_msg, reply_compact);
         send_udp(sender_ip, reply);
         return;
     }
 
     if (type == "ACK") {
-        node_->hb.clear_probe(sender_name);
+        // An unresolved compact header: the probe we sent to that address.
+        if (sender_name.empty()) sender_name = node_->hb.probe_target_at(sender_ip);
+        if (sender_name.empty()) return;
+
+        const uint64_t rtt_us = node_->hb.clear_probe(sender_name);
+        if (rtt_us) {
+            std::lock_guard<std::mutex> lk(node_->membership_mu);
+            auto it = node_->membership.find(sender_name);
+            if (it != node_->membership.end() && it->second.has_coord && fields.count("V"))
+                vivaldi_observe(*node_, sender_name, it->second.coord, (double)rtt_us / 1000.0);
+        }
+
+        uint64_t digest = 0;
+        auto it = fields.find("D");
+        if (it != fields.end() && parse_hex(it->second, digest))
+            node_->reconcile.on_digest(*node_, sender_name, sender_ip, digest);
+        return;
+    }
+
+    if (type == "SYNC") {
+        node_->reconcile.on_sync(*node_, sender_ip, data);
+        return;
+    }
+
+    if (type == "SYNC-DIFF") {
+        node_->reconcile.on_sync_diff(*node_, sender_ip, data);
+        return;
+    }
+
+    if (type == "SYNC-PUSH") {
+        node_->reconcile.on_sync_push(*node_, data);
         return;
     }
 
@@ -279,12 +453,14 @@ void UdpQueue::handle_datagram(const sockaddr_in& from, const std::string& paylo
     }
 
     if (type == "PING-REQ2") {
-        std::string reply = make_msg("ACK-REQ", *node_, data);
+        std::string reply = make_msg("ACK-REQ", *node_, data, reply_compact);
         send_udp(sender_ip, reply);
         return;
     }
 
     if (type == "ACK-REQ") {
+        // The requester needs the target's name; wait for WHOIS to give it.
+        if (sender_name.empty()) return;
         std::string forward = make_msg("ACK-REQ2", *node_, sender_name);
         send_udp(data, forward);
         return;
@@ -295,6 +471,39 @@ void UdpQueue::handle_datagram(const sockaddr_in& from, const std::string& paylo
         return;
     }
 
+    if (type == "WHOIS") {
+        std::string reply;
+        size_t entries = 0;
+        {
+            std::lock_guard<std::mutex> lk(node_->membership_mu);
+            size_t start = 0;
+            while (start < data.size() && entries < WHOIS_MAX_IDS) {
+                size_t comma = data.find(',', start);
+                if (comma == std::string::npos) comma = data.size();
+                const std::string id = data.substr(start, comma - start);
+                start = comma + 1;
+
+                // The asker lost our ID; back to full headers until it
+                // acknowledges again.
+                if (id == node_->id && !sender_name.empty()) {
+                    auto me = node_->membership.find(sender_name);
+                    if (me != node_->membership.end()) me->second.id_ack = false;
+                }
+
+                const std::string* n = node_->ids.resolve(id);
+                if (!n) continue;
+                auto it = node_->membership.find(*n);
+                if (it == node_->membership.end() || it->second.ip.empty()) continue;
+
+                if (!reply.empty()) reply.push_back(',');
+                reply += make_entry(*n, it->second);
+                entries++;
+            }
+        }
+        if (!reply.empty()) send_udp(sender_ip, make_msg("IAM", *node_, reply));
+        return;
+    }
+
     if (type == "PING-TEST") {
         std::string reply = make_msg("ACK-TEST", *node_);
         send_udp(sender_ip, reply);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <condition_variable>
 #include <deque>
 #include <mutex>
@@ -11,9 +12,46 @@
 
 class Node;
 
+inline constexpr size_t UDPQ_CAPACITY = 4096; // datagrams across all lanes
+
+// Lanes are served in strict priority order.
+enum class UdpLane : uint8_t {
+    ProbeReply,  // ACK, ACK-REQ, ACK-REQ2
+    Probe,       // PING, PING-REQ, PING-REQ2, SUSPECT, ALIVE, CONFIRM
+    Gossip,      // JOIN, WELCOME, REDIRECT, SYNC*, BCAST, anything unknown
+    Diagnostic,  // PING-TEST, ACK-TEST
+    Count
+};
+
+inline constexpr size_t UDP_LANES = (size_t)UdpLane::Count;
+
+// What to evict when the queue is full:
+//   DropOldest - the oldest queued datagram, whatever its lane;
+//   DropLowest - the oldest datagram of the lowest non-empty lane, or the
+//                arriving one if nothing queued ranks below it.
+enum class OverloadPolicy {
+    DropOldest,
+    DropLowest
+};
+
+UdpLane udp_lane_of(const char* data, size_t len);
+const char* udp_lane_name(UdpLane lane);
+
 struct UdpEvent {
     sockaddr_in from{};
     std::string payload;
+    uint64_t enqueued_us = 0;
+    uint64_t seq = 0;
+};
+
+struct UdpLaneStats {
+    uint64_t arrived = 0;
+    uint64_t dropped = 0;
+    uint64_t depth = 0;
+    uint64_t max_depth = 0;
+    uint64_t wait_p50_us = 0;
+    uint64_t wait_p99_us = 0;
+    uint64_t wait_max_us = 0;
 };
 
 class UdpQueue {
@@ -23,15 +61,43 @@ public:
 
     void enqueue(const sockaddr_in& from, const char* data, size_t len);
 
+    void set_policy(OverloadPolicy p);
+    OverloadPolicy policy() const;
+
+    UdpLaneStats lane_stats(UdpLane lane) const;
+    void reset_stats();
+
+    // Handles one datagram on the caller's thread, bypassing the lanes; a
+    // simulation attaches the node instead of starting the worker.
+    void attach(Node& node) { node_ = &node; }
+    void handle_datagram(const sockaddr_in& from, const std::string& payload);
+
 private:
     void worker_loop();
-    void handle_datagram(const sockaddr_in& from, const std::string& payload);
+
+    bool evict_locked(UdpLane incoming);
+    void record_wait_locked(UdpLane lane, uint64_t wait_us);
 
 private:
+    // Queue wait is bucketed by powers of two microseconds.
+    static constexpr size_t WAIT_BUCKETS = 32;
+
+    struct Lane {
+        std::deque<UdpEvent> q;
+        uint64_t arrived = 0;
+        uint64_t dropped = 0;
+        uint64_t max_depth = 0;
+        uint64_t wait_max_us = 0;
+        uint64_t wait_hist[WAIT_BUCKETS] = {};
+    };
+
     Node* node_ = nullptr;
-    std::mutex mu_;
+    mutable std::mutex mu_;
     std::condition_variable cv_;
-    std::deque<UdpEvent> q_;
+    Lane lanes_[UDP_LANES];
+    size_t size_ = 0;
+    uint64_t next_seq_ = 0;
+    OverloadPolicy policy_ = OverloadPolicy::DropLowest;
     std::thread th_;
     bool running_ = false;
-};
\ No newline at end of file
+};
@@ -0,0 +1,121 @@
+#include "vivaldi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+#include "node.h"
+
+double coord_distance(const Coord& a, const Coord& b) {
+    double sum = 0;
+    for (size_t i = 0; i < VIVALDI_DIM; i++) {
+        const double d = a.v[i] - b.v[i];
+        sum += d * d;
+    }
+    return std::sqrt(sum) + a.height + b.height;
+}
+
+void vivaldi_update(Coord& local, const Coord& remote, double rtt_ms, std::mt19937& rng) {
+    if (!(rtt_ms > 0) || rtt_ms > VIVALDI_MAX_RTT_MS) return;
+
+    const double dist = coord_distance(local, remote);
+    const double total = local.error + remote.error;
+    const double w = total > 0 ? local.error / total : 0.5;
+
+    const double rel = std::fabs(dist - rtt_ms) / rtt_ms;
+    local.error = std::min(rel * VIVALDI_CE * w + local.error * (1 - VIVALDI_CE * w), VIVALDI_MAX_ERROR);
+
+    const double force = VIVALDI_CC * w * (rtt_ms - dist);
+
+    // Unit vector from remote to local; random when the two coincide.
+    std::array<double, VIVALDI_DIM> u{};
+    double len = 0;
+    for (size_t i = 0; i < VIVALDI_DIM; i++) {
+        u[i] = local.v[i] - remote.v[i];
+        len += u[i] * u[i];
+    }
+    len = std::sqrt(len);
+    if (len < 1e-9) {
+        std::normal_distribution<double> nd(0.0, 1.0);
+        len = 0;
+        for (auto& x : u) { x = nd(rng); len += x * x; }
+        len = std::sqrt(len);
+    }
+
+    // The height absorbs its share of the force, like an extra dimension.
+    const double span = len + local.height + remote.height;
+    for (size_t i = 0; i < VIVALDI_DIM; i++) local.v[i] += force * u[i] / span;
+    local.height = std::max(local.height + force * (local.height + remote.height) / span,
+                            VIVALDI_MIN_HEIGHT_MS);
+}
+
+std::string encode_coord(const Coord& c) {
+    std::string out;
+    char buf[32];
+    for (size_t i = 0; i < VIVALDI_DIM; i++) {
+        snprintf(buf, sizeof(buf), "%.3f,", c.v[i]);
+        out += buf;
+    }
+    snprintf(buf, sizeof(buf), "%.3f,%.3f", c.height, c.error);
+    out += buf;
+    return out;
+}
+
+bool decode_coord(const std::string& s, Coord& c) {
+    double vals[VIVALDI_DIM + 2];
+    const char* p = s.c_str();
+
+    for (size_t i = 0; i < VIVALDI_DIM + 2; i++) {
+        char* end = nullptr;
+        vals[i] = std::strtod(p, &end);
+        if (end == p || !std::isfinite(vals[i]) || std::fabs(vals[i]) > VIVALDI_MAX_RTT_MS) return false;
+        if (i + 1 < VIVALDI_DIM + 2) {
+            if (*end != ',') return false;
+            p = end + 1;
+        } else if (*end != '\0') {
+            return false;
+        }
+    }
+
+    Coord out;
+    for (size_t i = 0; i < VIVALDI_DIM; i++) out.v[i] = vals[i];
+    out.height = std::max(vals[VIVALDI_DIM], VIVALDI_MIN_HEIGHT_MS);
+    out.error = std::clamp(vals[VIVALDI_DIM + 1], 0.001, VIVALDI_MAX_ERROR);
+    c = out;
+    return true;
+}
+
+void vivaldi_observe(Node& node, const std::string& peer, const Coord& remote, double rtt_ms) {
+    auto self = node.membership.find(node.name);
+    if (self == node.membership.end() || peer == node.name) return;
+
+    static thread_local std::mt19937 rng(std::random_device{}());
+    vivaldi_update(self->second.coord, remote, rtt_ms, rng);
+}
+
+std::string coord_field(const Node& node) {
+    auto self = node.membership.find(node.name);
+    if (self == node.membership.end()) return "";
+    return "V=" + encode_coord(self->second.coord);
+}
+
+std::vector<std::pair<std::string, double>> nearest_members(Node& node, const std::string& to, size_t n) {
+    std::vector<std::pair<std::string, double>> out;
+
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+    auto from = node.membership.find(to);
+    if (from == node.membership.end() || !from->second.has_coord) return out;
+
+    for (const auto& [name, info] : node.membership) {
+        if (name == to || !info.has_coord || info.status != MemberStatus::Alive) continue;
+        out.emplace_back(name, coord_distance(from->second.coord, info.coord));
+    }
+
+    const size_t k = std::min(n, out.size());
+    std::partial_sort(out.begin(), out.begin() + k, out.end(),
+                      [](const auto& a, const auto& b) { return a.second < b.second; });
+    out.resize(k);
+    return out;
+}
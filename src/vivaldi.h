@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Node;
+
+// Vivaldi network coordinates (Dabek et al., with the height vector from
+// the paper's section 5). Each node places itself in a small Euclidean
+// space plus a non-negative "height" for its access link, so the distance
+// between two coordinates estimates the RTT between the nodes in ms.
+//
+// A node moves its own coordinate after every direct PING/ACK round trip,
+// using the RTT and the peer's coordinate carried in the ACK. Every
+// piggyback carries the sender's coordinate as
+//
+//   V=<x0>,<x1>,<x2>,<x3>,<height>,<error>
+//
+// and the receiver stores it on the sender's MemberInfo.
+
+inline constexpr size_t VIVALDI_DIM = 4;
+
+inline constexpr double VIVALDI_CE = 0.25;           // error smoothing
+inline constexpr double VIVALDI_CC = 0.25;           // movement step
+inline constexpr double VIVALDI_MAX_ERROR = 1.5;     // also the initial error
+inline constexpr double VIVALDI_MIN_HEIGHT_MS = 0.01;
+inline constexpr double VIVALDI_MAX_RTT_MS = 10000.0;
+
+struct Coord {
+    std::array<double, VIVALDI_DIM> v{};
+    double height = VIVALDI_MIN_HEIGHT_MS;
+    double error = VIVALDI_MAX_ERROR;
+};
+
+// Estimated RTT in ms between the nodes at `a` and `b`.
+double coord_distance(const Coord& a, const Coord& b);
+
+// Moves `local` toward or away from `remote` given a measured RTT.
+void vivaldi_update(Coord& local, const Coord& remote, double rtt_ms, std::mt19937& rng);
+
+std::string encode_coord(const Coord& c);
+bool decode_coord(const std::string& s, Coord& c);
+
+// Feeds a direct round trip to `peer` into our own coordinate. Caller must
+// hold node.membership_mu.
+void vivaldi_observe(Node& node, const std::string& peer, const Coord& remote, double rtt_ms);
+
+// The V= field for our piggybacks. Caller must hold node.membership_mu.
+std::string coord_field(const Node& node);
+
+// Up to n Alive members with a known coordinate, nearest to member `to`
+// first, with the estimated RTT in ms. Locks membership_mu.
+std::vector<std::pair<std::string, double>> nearest_members(Node& node, const std::string& to, size_t n);
@@ -0,0 +1,48 @@
+#include "zones.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "hash_util.h"
+#include "node.h"
+
+const std::string& zone_of(const MemberInfo& m) {
+    static const std::string none;
+    auto it = m.meta.find(ZONE_KEY);
+    return it == m.meta.end() ? none : it->second;
+}
+
+uint64_t rep_rank(const std::string& name) {
+    return mix64(fnv1a64(name));
+}
+
+ZoneReps zone_representatives(const Node& node) {
+    return node.schedule.representatives();
+}
+
+bool is_representative(const ZoneReps& reps, const std::string& zone, const std::string& name) {
+    auto it = reps.find(zone);
+    return it != reps.end() && std::find(it->second.begin(), it->second.end(), name) != it->second.end();
+}
+
+std::vector<ZoneSummary> zone_summaries(const Node& node) {
+    std::lock_guard<std::mutex> lk(node.membership_mu);
+
+    std::map<std::string, ZoneSummary> by_zone;
+    for (const auto& [name, info] : node.membership) {
+        ZoneSummary& z = by_zone[zone_of(info)];
+        if (info.status == MemberStatus::Alive) z.alive++;
+        else if (info.status == MemberStatus::Suspect) z.suspect++;
+        else z.dead++;
+    }
+
+    const ZoneReps reps = zone_representatives(node);
+    std::vector<ZoneSummary> out;
+    for (auto& [zone, z] : by_zone) {
+        z.zone = zone;
+        auto it = reps.find(zone);
+        if (it != reps.end()) z.representatives = it->second;
+        out.push_back(std::move(z));
+    }
+    return out;
+}
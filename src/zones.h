@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class Node;
+struct MemberInfo;
+
+inline const char* const ZONE_KEY = "zone";
+
+// A member's zone: its "zone" metadata tag, "" if untagged. Untagged
+// members form one zone of their own, so a cluster without tags gossips
+// exactly as before.
+const std::string& zone_of(const MemberInfo& m);
+
+// Representatives of every zone, best first: the ZONE_REPRESENTATIVES alive
+// members with the lowest rep_rank(name). Every member computes the same
+// set from a converged view, and a failed representative is replaced by the
+// next one. Kept by node.schedule; caller must hold node.membership_mu.
+using ZoneReps = std::map<std::string, std::vector<std::string>>;
+ZoneReps zone_representatives(const Node& node);
+
+uint64_t rep_rank(const std::string& name);
+
+bool is_representative(const ZoneReps& reps, const std::string& zone, const std::string& name);
+
+struct ZoneSummary {
+    std::string zone;
+    size_t alive = 0;
+    size_t suspect = 0;
+    size_t dead = 0;
+    std::vector<std::string> representatives;
+};
+
+// One row per zone in the view. Locks membership_mu.
+std::vector<ZoneSummary> zone_summaries(const Node& node);